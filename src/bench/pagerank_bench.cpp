@@ -0,0 +1,80 @@
+/*
+ * PageRank benchmark
+ *
+ * pagerank-bench                 random power law graph
+ * pagerank-bench edges.txt       SNAP / Matrix Market edge list
+ *
+ * Configure with -DCMAKE_BUILD_TYPE=Release, add -DENABLE_NATIVE_ARCH=ON for the AVX2 gather path.
+ */
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../graph/edge_list_loader.h"
+#include "../graph/pagerank.h"
+
+using Graph = CsrGraph<uint32_t, uint32_t, float>;
+using Buffer = ArenaBuffer<(size_t(1) << 30)>;
+
+static double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    auto buf = std::make_unique<Buffer>();
+    ThreadPool pool;
+
+    size_t outOffset, inOffset;
+    auto start = std::chrono::steady_clock::now();
+    if (argc > 1) {
+        if (!loadTextEdgeList<Graph>(pool, *buf, argv[1], outOffset)) {
+            printf("Can not load %s (missing, malformed or larger than the %zu MiB arena)\n", argv[1], sizeof(buf->data) >> 20);
+            return 1;
+        }
+    } else {
+        // skewed degrees: targets drawn with a power law, hubs get most in-edges
+        const uint32_t vertexNum = 1 << 20;
+        const uint32_t edgeNum = 16 << 20;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::vector<GraphEdge<uint32_t, float>> edges(edgeNum);
+        for (auto& edge : edges) {
+            edge.from = random() % vertexNum;
+            edge.to = uint32_t(vertexNum * std::pow(uniform(random), 3.0)) % vertexNum;
+        }
+        outOffset = buildCsrGraphFromEdges<Graph>(*buf, vertexNum, edges.data(), edges.size(), false);
+    }
+    const Graph* loadedGraph = getCsrGraph<Graph>(*buf, outOffset);
+    if (!csrGraphFits<Graph>(*buf, loadedGraph->vertexNum, loadedGraph->edgeNum, loadedGraph->isWeighted())) {
+        printf("Transposed graph does not fit the %zu MiB arena\n", sizeof(buf->data) >> 20);
+        return 1;
+    }
+    inOffset = buildTransposedCsrGraph(*buf, loadedGraph);
+    const Graph* outGraph = getCsrGraph<Graph>(*buf, outOffset);
+    const Graph* inGraph = getCsrGraph<Graph>(*buf, inOffset);
+    printf("Graph: %u vertices, %u edges, built in %.1f ms\n", outGraph->vertexNum, outGraph->edgeNum, msSince(start));
+
+#ifdef __AVX2__
+    printf("Gather: AVX2\n");
+#else
+    printf("Gather: scalar\n");
+#endif
+
+    std::vector<int> threadNums { 1 };
+    if (pool.getThreadNum() > 1)
+        threadNums.push_back(pool.getThreadNum());
+
+    for (int threadNum : threadNums) {
+        ThreadPool benchPool(threadNum);
+        start = std::chrono::steady_clock::now();
+        const PageRankResult result = pageRank(benchPool, inGraph, outGraph, 0.85f, 0.0, 20); // fixed 20 iterations
+        const double ms = msSince(start);
+        const double bytesPerIteration = (double)inGraph->edgeNum * (sizeof(uint32_t) + sizeof(float)) + (double)inGraph->vertexNum * 16;
+        printf("Threads: %2d  %.2f ms/iteration  %.2f GB/s  error %.2e\n", threadNum, ms / result.iterations,
+            bytesPerIteration * result.iterations / (ms * 1e6), result.error);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef ARENA_BUFFER_H
+#define ARENA_BUFFER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+template <int alignSize>
+inline constexpr size_t alignToSize(size_t p)
+{
+    static_assert(((alignSize - 1) & alignSize) == 0); // is pow of 2
+    constexpr size_t alignMask = (alignSize - 1);
+    return (p + alignMask) & ~alignMask;
+}
+
+// pre-allocated buffer
+template <size_t Capacity>
+class ArenaBuffer {
+
+public:
+    size_t size {};
+    uint8_t data[Capacity] {};
+
+    // return offset from data aligned to T
+    template <typename T>
+    size_t allocate(size_t num)
+    {
+        const size_t alignedPtrStart = alignToSize<alignof(T)>((size_t)data + size);
+        const size_t alignedOffsetStart = alignedPtrStart - (size_t)data;
+        size = alignedOffsetStart + num * sizeof(T);
+
+        assert(size < sizeof(data));
+        return alignedOffsetStart;
+    }
+};
+
+#endif // ARENA_BUFFER_H
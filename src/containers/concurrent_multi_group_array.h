@@ -0,0 +1,141 @@
+#ifndef CONCURRENT_MULTI_GROUP_ARRAY_H
+#define CONCURRENT_MULTI_GROUP_ARRAY_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "multi_group_array.h"
+
+/* ConcurrentMultiGroupArray
+ *
+ * MultiGroupArray for many producer threads.
+ * Producers never touch the contiguous array, they append to a per-group shard.
+ * consolidate() drains all shards and merges them into a NEW array in one pass,
+ * then publishes it as the current snapshot. Readers hold a shared_ptr to an immutable
+ * snapshot, so consolidation never changes what they see.
+ *
+ * SHARD
+ * Two fixed size buffers, producers write to the active one:
+ *   1. writerNum[active]++, recheck active (consolidator may have just flipped it)
+ *   2. slot = reserved[active]++, write item
+ *   3. writerNum[active]--
+ * Consolidator flips active, waits writerNum[old] == 0, merges old buffer, resets it.
+ * Flip/writerNum and writerNum++/recheck are store-then-load on different atomics (Dekker),
+ * all four are seq_cst, acquire/release would let a writer slip into the old buffer after the check.
+ *
+ * ConcurrentMultiGroupArray<Request, 8> requests(1 << 16);
+ * // producer threads
+ * if (!requests.tryAddItem(group, request)) // shard is full until next consolidate()
+ *     ...
+ * // service thread
+ * requests.consolidate();
+ * // reader threads
+ * auto snapshot = requests.snapshot();
+ * snapshot->forEachItemInGroup(...)
+ */
+
+template <typename ClassType, int MaxGroupNum>
+class ConcurrentMultiGroupArray {
+public:
+    using Array = MultiGroupArray<ClassType, MaxGroupNum>;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<int> activeBuffer { 0 };
+        std::atomic<int> writerNum[2] {};
+        std::atomic<int> reserved[2] {};
+        std::vector<ClassType> buffers[2];
+    };
+
+    std::unique_ptr<Shard[]> m_shards;
+    const int m_shardCapacity;
+
+    std::shared_ptr<const Array> m_snapshot;
+    std::mutex m_consolidateMutex; // between consolidators only
+
+public:
+    explicit ConcurrentMultiGroupArray(int shardCapacity = 1 << 12)
+        : m_shards(new Shard[MaxGroupNum])
+        , m_shardCapacity(shardCapacity)
+        , m_snapshot(std::make_shared<const Array>())
+    {
+        assert(shardCapacity > 0);
+        for (int groupIndex = 0; groupIndex < MaxGroupNum; ++groupIndex)
+            for (auto& buffer : m_shards[groupIndex].buffers)
+                buffer.resize(shardCapacity);
+    }
+
+    // lock-free, false if the group shard is full, item becomes visible after consolidate()
+    bool tryAddItem(int groupIndex, const ClassType& item)
+    {
+        assert(groupIndex >= 0 && groupIndex < MaxGroupNum);
+        Shard& shard = m_shards[groupIndex];
+
+        int bufferIndex;
+        for (;;) {
+            bufferIndex = shard.activeBuffer.load();
+            shard.writerNum[bufferIndex].fetch_add(1, std::memory_order_seq_cst);
+            if (shard.activeBuffer.load(std::memory_order_seq_cst) == bufferIndex)
+                break;
+            shard.writerNum[bufferIndex].fetch_sub(1); // flipped in between, retry on the new one
+        }
+
+        bool added = false;
+        if (shard.reserved[bufferIndex].load(std::memory_order_relaxed) < m_shardCapacity) {
+            const int slot = shard.reserved[bufferIndex].fetch_add(1);
+            if (slot < m_shardCapacity) {
+                shard.buffers[bufferIndex][slot] = item;
+                added = true;
+            }
+        }
+
+        shard.writerNum[bufferIndex].fetch_sub(1, std::memory_order_release);
+        return added;
+    }
+
+    // immutable, stays valid while held
+    std::shared_ptr<const Array> snapshot() const { return std::atomic_load(&m_snapshot); }
+
+    // merge all shards into a new snapshot, returns number of merged items
+    int consolidate()
+    {
+        std::lock_guard<std::mutex> lock(m_consolidateMutex);
+
+        std::array<const ClassType*, MaxGroupNum> arrays;
+        std::array<int, MaxGroupNum> lengths;
+        std::array<int, MaxGroupNum> drainedBuffers;
+        int addedNum = 0;
+
+        for (int groupIndex = 0; groupIndex < MaxGroupNum; ++groupIndex) {
+            Shard& shard = m_shards[groupIndex];
+            const int bufferIndex = shard.activeBuffer.load();
+            assert(shard.reserved[1 - bufferIndex].load() == 0);
+            shard.activeBuffer.store(1 - bufferIndex, std::memory_order_seq_cst);
+
+            while (shard.writerNum[bufferIndex].load(std::memory_order_seq_cst) != 0)
+                std::this_thread::yield();
+
+            drainedBuffers[groupIndex] = bufferIndex;
+            arrays[groupIndex] = shard.buffers[bufferIndex].data();
+            lengths[groupIndex] = std::min(shard.reserved[bufferIndex].load(), m_shardCapacity);
+            addedNum += lengths[groupIndex];
+        }
+
+        if (addedNum > 0) {
+            auto newArray = std::make_shared<Array>(*snapshot());
+            newArray->addItemArrays(arrays, lengths);
+            std::atomic_store(&m_snapshot, std::shared_ptr<const Array>(std::move(newArray)));
+        }
+
+        for (int groupIndex = 0; groupIndex < MaxGroupNum; ++groupIndex)
+            m_shards[groupIndex].reserved[drainedBuffers[groupIndex]].store(0);
+
+        return addedNum;
+    }
+
+    int getShardCapacity() const { return m_shardCapacity; }
+};
+
+#endif // CONCURRENT_MULTI_GROUP_ARRAY_H
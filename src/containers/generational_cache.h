@@ -0,0 +1,218 @@
+#ifndef GENERATIONAL_CACHE_H
+#define GENERATIONAL_CACHE_H
+
+#include <cstdint>
+#include <functional>
+
+#include "multi_group_array.h"
+
+/* GenerationalCache
+ *
+ * Fixed capacity key-value cache with approximate LRU eviction.
+ * Entries live in a MultiGroupArray, each group is an age generation,
+ * the last group is the youngest, so new entries are appended to the end of the array.
+ *
+ *  oldest                          youngest
+ * | gen 0      | gen 1    | gen 2  | gen 3 |
+ *
+ * Insert: append to youngest generation.
+ * Hit: move entry to youngest generation, at most one move per generation
+ *      (same hole chain as removeItemUnordered, moveItemToGroup would shift every item in between).
+ * Aging: when youngest generation is full, oldest generation is dropped wholesale,
+ *        splits move one group left and a new empty youngest generation appears.
+ *
+ * Open-addressing index (linear probing, backward shift deletion) maps key to array position.
+ * Positions are stored with a bias: dropping the oldest generation shifts every position
+ * by the same amount, so only the bias changes, not the whole index.
+ *
+ * GenerationalCache<uint64_t, Texture, 4> cache(1024);
+ * if (Texture* t = cache.find(id)) ... // hit, promoted
+ * else cache.insert(id, loadTexture(id));
+ */
+
+template <typename Key, typename Value>
+struct CacheEntry {
+    Key key;
+    Value value;
+};
+
+template <typename Key, typename Value, int Generations = 4, typename Hash = std::hash<Key>>
+class GenerationalCache : protected MultiGroupArray<CacheEntry<Key, Value>, Generations> {
+    static_assert(Generations >= 2);
+
+    using Entry = CacheEntry<Key, Value>;
+    using Base = MultiGroupArray<Entry, Generations>;
+    static constexpr int youngest = Generations - 1;
+    static constexpr uint64_t emptySlot = UINT64_MAX;
+
+    int m_capacity;
+    int m_generationCapacity;
+
+    std::vector<uint64_t> m_slots; // position + m_positionBias, or emptySlot
+    int m_slotBits;
+    uint64_t m_positionBias {};
+
+    Hash m_hash;
+
+    size_t homeSlot(const Key& key) const
+    {
+        return (uint64_t(m_hash(key)) * 0x9E3779B97F4A7C15ull) >> (64 - m_slotBits); // fibonacci hashing
+    }
+
+    size_t slotMask() const { return m_slots.size() - 1; }
+    int slotPosition(size_t slot) const { return m_slots[slot] - m_positionBias; }
+
+    // slot with key, or empty slot where it would be inserted
+    size_t findSlot(const Key& key) const
+    {
+        size_t slot = homeSlot(key);
+        while (m_slots[slot] != emptySlot && !(this->m_itemArray[slotPosition(slot)].key == key))
+            slot = (slot + 1) & slotMask();
+        return slot;
+    }
+
+    void eraseSlot(size_t hole)
+    {
+        for (size_t slot = (hole + 1) & slotMask(); m_slots[slot] != emptySlot; slot = (slot + 1) & slotMask()) {
+            const size_t home = homeSlot(this->m_itemArray[slotPosition(slot)].key);
+            // entry may move to the hole if the hole lies cyclically in [home, slot)
+            if (((slot - home) & slotMask()) >= ((slot - hole) & slotMask())) {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+        m_slots[hole] = emptySlot;
+    }
+
+    void moveEntry(int from, int to)
+    {
+        m_slots[findSlot(this->m_itemArray[from].key)] = to + m_positionBias;
+        this->m_itemArray[to] = std::move(this->m_itemArray[from]);
+    }
+
+    // removeItemUnordered with index updates, entry must already be out of the index
+    Entry extractEntry(int itemIndex)
+    {
+        Entry entry = std::move(this->m_itemArray[itemIndex]);
+
+        int hole = itemIndex;
+        for (int groupIndex = this->getItemGroup(itemIndex, 0); groupIndex < Generations; ++groupIndex) {
+            const int groupLast = this->groupPosR(groupIndex) - 1;
+            if (groupLast != hole)
+                moveEntry(groupLast, hole);
+            hole = groupLast;
+            if (groupIndex < Generations - 1)
+                this->m_splits.at(groupIndex)--;
+        }
+        this->m_itemArray.pop_back();
+        return entry;
+    }
+
+    // drop oldest generation, every other generation gets one older
+    void age()
+    {
+        const int droppedNum = this->groupPosR(0);
+        for (int i = 0; i < droppedNum; ++i)
+            eraseSlot(findSlot(this->m_itemArray[i].key));
+
+        this->m_itemArray.erase(this->m_itemArray.begin(), this->m_itemArray.begin() + droppedNum);
+        m_positionBias += droppedNum;
+
+        for (int i = 0; i < Generations - 2; ++i)
+            this->m_splits.at(i) = this->m_splits.at(i + 1) - droppedNum;
+        this->m_splits.at(Generations - 2) = this->m_itemArray.size();
+    }
+
+    Value& appendYoungest(Entry&& entry)
+    {
+        if (this->getGroupSize(youngest) >= m_generationCapacity)
+            age();
+
+        const size_t slot = findSlot(entry.key);
+        assert(m_slots[slot] == emptySlot);
+        m_slots[slot] = this->m_itemArray.size() + m_positionBias;
+        this->m_itemArray.push_back(std::move(entry));
+        return this->m_itemArray.back().value;
+    }
+
+public:
+    explicit GenerationalCache(int capacity, Hash hash = {})
+        : m_capacity(capacity)
+        , m_generationCapacity(std::max(1, capacity / Generations))
+        , m_hash(hash)
+    {
+        assert(capacity > 0);
+        m_slotBits = 1;
+        while ((1 << m_slotBits) < 2 * capacity) // load factor <= 0.5
+            m_slotBits++;
+        m_slots.assign(size_t(1) << m_slotBits, emptySlot);
+        this->m_itemArray.reserve(m_generationCapacity * Generations + 1);
+    }
+
+    // hit promotes entry to the youngest generation
+    Value* find(const Key& key)
+    {
+        const size_t slot = findSlot(key);
+        if (m_slots[slot] == emptySlot)
+            return nullptr;
+
+        const int itemIndex = slotPosition(slot);
+        if (itemIndex >= this->groupPosL(youngest))
+            return &this->m_itemArray[itemIndex].value;
+
+        eraseSlot(slot);
+        return &appendYoungest(extractEntry(itemIndex));
+    }
+
+    // no promotion
+    const Value* peek(const Key& key) const
+    {
+        const size_t slot = findSlot(key);
+        return (m_slots[slot] == emptySlot) ? nullptr : &this->m_itemArray[slotPosition(slot)].value;
+    }
+
+    bool contains(const Key& key) const { return m_slots[findSlot(key)] != emptySlot; }
+
+    // insert or overwrite, entry becomes youngest
+    Value& insert(const Key& key, Value value)
+    {
+        if (Value* existing = find(key)) {
+            *existing = std::move(value);
+            return *existing;
+        }
+        return appendYoungest(Entry { key, std::move(value) });
+    }
+
+    bool erase(const Key& key)
+    {
+        const size_t slot = findSlot(key);
+        if (m_slots[slot] == emptySlot)
+            return false;
+
+        const int itemIndex = slotPosition(slot);
+        eraseSlot(slot);
+        extractEntry(itemIndex);
+        return true;
+    }
+
+    void clear()
+    {
+        Base::clear();
+        m_slots.assign(m_slots.size(), emptySlot);
+        m_positionBias = 0;
+    }
+
+    int size() const { return this->m_itemArray.size(); }
+    int getCapacity() const { return m_capacity; }
+    int getGenerationSize(int generation) const { return this->getGroupSize(generation); }
+
+    // oldest to youngest
+    template <typename Fn>
+    void forEachEntry(Fn&& fn) const
+    {
+        for (const Entry& entry : this->m_itemArray)
+            fn(entry.key, entry.value);
+    }
+};
+
+#endif // GENERATIONAL_CACHE_H
@@ -1,13 +1,22 @@
 #ifndef MULTI_GROUP_ARRAY_H
 #define MULTI_GROUP_ARRAY_H
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "../utils/thread_pool.h"
+
 /* MultiGroupAttay
  * Separate repo: https://github.com/smarchevsky/MultiGroupArray
  *
@@ -81,9 +90,102 @@
  *
  * // group0 group2
  * //  ABCD   IJKL
+ *
+ * // order inside groups is not needed: at most one move per group instead of shifting the tail
+ * int indexB = mcArray.getItemIndexByPredicate([&](const char& c) { return c == 'B'; }); // 1
+ * mcArray.removeItemUnordered(indexB); // last item of every group from B's onward fills the hole
+ * // group0 group2
+ * //  ADC    LIJK
+ *
+ *
+ * BULK LOAD
+ *
+ * Filling with addItem() shifts the tail on every insert, O(N^2) for N items.
+ * assign() (or the range constructor) does a counting sort instead:
+ * histogram of group keys -> splits by prefix sum -> scatter, O(N + MaxGroupNum).
+ * Order of items inside a group is the same as in the input range.
+ *
+ * std::vector<Entity> entities = ...;
+ * MultiGroupArray<Entity, 8> arr(entities.begin(), entities.end(),
+ *     [](const Entity& e) { return e.type; }, 4); // 4 threads for histogram and scatter
+ *
+ *
+ * PARALLEL PASSES
+ *
+ * The array is cut into chunks that never cross a group split.
+ * Inner chunk borders are multiples of chunkItemNum from the array start.
+ * Passes only read items, so tasks sharing a cache line at a border is harmless.
+ *
+ *   group0        group1                    group2
+ * |-----|-------|---|-------|-------|-----|--------|
+ *  chunk  chunk      chunk   chunk        chunk
+ *
+ * ThreadPool pool;
+ * arr.parallelForEachChunk(pool, [](int group, const Entity* items, int num) { ... }); // task per chunk
+ * arr.parallelForEachGroup(pool, [](int group, const Entity* items, int num) { ... }); // task per group
+ * auto sums = arr.parallelGroupSum(pool, [](const Entity& e) { return e.mass; });
+ *
+ *
+ * SORTED GROUPS
+ *
+ * SortedMultiGroupArray keeps every group sorted by Compare, layout is the same.
+ * Insert is binary search + shift, find is binary search in [groupPosL, groupPosR),
+ * so per group lookup is O(log n) instead of a full scan.
+ *
+ * SortedMultiGroupArray<int, 4> sorted;
+ * sorted.insertSorted(1, 42);
+ * sorted.insertSortedArray(1, values, valueNum); // sort + one merge, not valueNum shifts
+ * int index = sorted.findInGroup(1, 42); // INDEX_INVALID if not found
+ *
+ *
+ * FILE FORMAT (trivially copyable items only)
+ *
+ * | MultiGroupArrayFileHeader | splits (int32 x MaxGroupNum-1) | padding | raw items |
+ *                                                                       ^ itemsOffset, 64 aligned
+ *
+ * arr.saveToFile("entities.mga"); // two large sequential writes
+ * arr.loadFromFile("entities.mga"); // copy into owned array
+ * MultiGroupArrayView<Entity, 8> view; // zero copy, mmap, multi_group_array_view.h
+ * view.open("entities.mga");
+ *
+ *
+ * CONCURRENT APPENDS
+ *
+ * ConcurrentMultiGroupArray (concurrent_multi_group_array.h) gives every group a lock-free
+ * append buffer, consolidate() merges them with addItemArrays() into a new immutable snapshot.
  */
 
+struct IdentityProjection {
+    template <typename T>
+    const T& operator()(const T& value) const { return value; }
+};
+
 #define INDEX_INVALID -1
+
+struct MultiGroupArrayFileHeader {
+    static constexpr uint32_t currentMagic = 0x3141474d; // "MGA1"
+    static constexpr uint64_t itemsAlignment = 64;
+
+    uint32_t magic;
+    uint32_t itemSize;
+    uint32_t itemAlign;
+    uint32_t groupNum;
+    uint64_t itemNum;
+    uint64_t itemsOffset;
+
+    static constexpr uint64_t calcItemsOffset(int groupNum)
+    {
+        const uint64_t splitsEnd = sizeof(MultiGroupArrayFileHeader) + sizeof(int32_t) * (groupNum - 1);
+        return (splitsEnd + itemsAlignment - 1) & ~(itemsAlignment - 1);
+    }
+
+    template <typename ClassType, int MaxGroupNum>
+    bool isCompatible() const
+    {
+        return magic == currentMagic && itemSize == sizeof(ClassType) && itemAlign == alignof(ClassType)
+            && groupNum == MaxGroupNum && itemsOffset == calcItemsOffset(MaxGroupNum);
+    }
+};
 template <typename ClassType, int MaxGroupNum>
 class MultiGroupArray {
 protected:
@@ -136,9 +238,90 @@ protected:
         offsetSplits(arrayLengthDiff, newGroupIndex);
     }
 
+    // insert before itemIndex, itemIndex must be in [groupPosL, groupPosR] of groupIndex
+    void insertData(int groupIndex, int itemIndex, const ClassType* newData, int newArrayLength)
+    {
+        assert(itemIndex >= groupPosL(groupIndex) && itemIndex <= groupPosR(groupIndex));
+        m_itemArray.insert(m_itemArray.begin() + itemIndex, newData, newData + newArrayLength);
+        offsetSplits(newArrayLength, groupIndex);
+    }
+
+    // runs fn(threadIndex) on threadNum threads, current thread is thread 0
+    template <typename Fn>
+    static void runOnThreads(int threadNum, Fn&& fn)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(threadNum - 1);
+        for (int t = 1; t < threadNum; ++t)
+            threads.emplace_back(fn, t);
+        fn(0);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
 public:
     MultiGroupArray() { clear(); }
 
+    template <typename InputIt, typename GroupKeyFunc>
+    MultiGroupArray(InputIt first, InputIt last, GroupKeyFunc groupKey, int threadNum = 1)
+    {
+        assign(first, last, groupKey, threadNum);
+    }
+
+    // Counting sort bulk load, replaces current content.
+    // groupKey(item) returns group index in [0, MaxGroupNum). It is called twice per item.
+    // threadNum > 1 is used only for random access iterators.
+    template <typename InputIt, typename GroupKeyFunc>
+    void assign(InputIt first, InputIt last, GroupKeyFunc groupKey, int threadNum = 1)
+    {
+        using IteratorCategory = typename std::iterator_traits<InputIt>::iterator_category;
+        static_assert(std::is_base_of_v<std::forward_iterator_tag, IteratorCategory>, "range is read twice");
+        static constexpr int minItemsPerThread = 1 << 14;
+
+        const int itemNum = std::distance(first, last);
+        if constexpr (!std::is_base_of_v<std::random_access_iterator_tag, IteratorCategory>)
+            threadNum = 1;
+        threadNum = std::max(1, std::min(threadNum, itemNum / minItemsPerThread));
+
+        auto chunkL = [&](int t) { return (int)((int64_t)itemNum * t / threadNum); };
+
+        // each thread counts its own chunk
+        std::vector<std::array<int, MaxGroupNum>> positions(threadNum);
+        runOnThreads(threadNum, [&](int t) {
+            auto& histogram = positions[t];
+            histogram.fill(0);
+            auto it = std::next(first, chunkL(t));
+            for (int i = chunkL(t); i < chunkL(t + 1); ++i, ++it) {
+                const int groupIndex = groupKey(*it);
+                assert(groupIndex >= 0 && groupIndex < MaxGroupNum);
+                ++histogram[groupIndex];
+            }
+        });
+
+        // group major, thread minor prefix sum keeps input order inside each group
+        int pos = 0;
+        for (int groupIndex = 0; groupIndex < MaxGroupNum; ++groupIndex) {
+            for (int t = 0; t < threadNum; ++t) {
+                const int count = positions[t][groupIndex];
+                positions[t][groupIndex] = pos;
+                pos += count;
+            }
+            if (groupIndex < MaxGroupNum - 1)
+                m_splits.at(groupIndex) = pos;
+        }
+        assert(pos == itemNum);
+
+        m_itemArray.clear();
+        m_itemArray.resize(itemNum);
+
+        runOnThreads(threadNum, [&](int t) {
+            auto& writePos = positions[t];
+            auto it = std::next(first, chunkL(t));
+            for (int i = chunkL(t); i < chunkL(t + 1); ++i, ++it)
+                m_itemArray[writePos[groupKey(*it)]++] = *it;
+        });
+    }
+
     void clear()
     {
         m_itemArray.clear();
@@ -219,8 +402,8 @@ public:
         return m_itemArray.data() + posL;
     }
 
-    ClassType* getItemByIndex(int itemIndex) { return &m_itemArray.at(); }
-    const ClassType* getItemByIndex(int itemIndex) const { return &m_itemArray.at(); }
+    ClassType* getItemByIndex(int itemIndex) { return &m_itemArray.at(itemIndex); }
+    const ClassType* getItemByIndex(int itemIndex) const { return &m_itemArray.at(itemIndex); }
 
     int getItemIndexByPredicate(std::function<bool(const ClassType&)> predicate) const
     {
@@ -230,7 +413,7 @@ public:
         return INDEX_INVALID;
     }
 
-    void forEachItemInGroup(int groupIndex, std::function<void(const ClassType&)> predicate)
+    void forEachItemInGroup(int groupIndex, std::function<void(const ClassType&)> predicate) const
     {
         int posL = groupPosL(groupIndex);
         int posR = groupPosR(groupIndex);
@@ -238,12 +421,148 @@ public:
             predicate(m_itemArray[i]);
     }
 
-    void forEachItem(std::function<void(const ClassType&)> predicate)
+    void forEachItem(std::function<void(const ClassType&)> predicate) const
     {
         for (int i = 0; i < m_itemArray.size(); ++i)
             predicate(m_itemArray[i]);
     }
 
+    struct ItemChunk {
+        int groupIndex, itemBegin, itemEnd;
+    };
+
+    // chunks of about chunkItemNum items in [groupIndexBegin, groupIndexEnd), empty groups are skipped
+    std::vector<ItemChunk> makeChunks(int chunkItemNum, int groupIndexBegin = 0, int groupIndexEnd = MaxGroupNum) const
+    {
+        chunkItemNum = std::max(1, chunkItemNum);
+
+        std::vector<ItemChunk> chunks;
+        for (int groupIndex = groupIndexBegin; groupIndex < groupIndexEnd; ++groupIndex) {
+            const int posL = groupPosL(groupIndex);
+            const int posR = groupPosR(groupIndex);
+            for (int begin = posL; begin < posR;) {
+                int end = std::min(posR, (begin / chunkItemNum + 1) * chunkItemNum); // next border
+                chunks.push_back({ groupIndex, begin, end });
+                begin = end;
+            }
+        }
+        return chunks;
+    }
+
+    // fn(groupIndex, items, itemNum), task per chunk
+    template <typename Fn>
+    void parallelForEachChunk(ThreadPool& pool, Fn&& fn, int chunkItemNum = 4096,
+        int groupIndexBegin = 0, int groupIndexEnd = MaxGroupNum) const
+    {
+        const auto chunks = makeChunks(chunkItemNum, groupIndexBegin, groupIndexEnd);
+        pool.parallelFor(chunks.size(), [&](int chunkIndex) {
+            const ItemChunk& chunk = chunks[chunkIndex];
+            fn(chunk.groupIndex, m_itemArray.data() + chunk.itemBegin, chunk.itemEnd - chunk.itemBegin);
+        });
+    }
+
+    // fn(groupIndex, items, itemNum), task per group, empty groups are skipped
+    template <typename Fn>
+    void parallelForEachGroup(ThreadPool& pool, Fn&& fn) const
+    {
+        pool.parallelFor(MaxGroupNum, [&](int groupIndex) {
+            const int posL = groupPosL(groupIndex);
+            const int posR = groupPosR(groupIndex);
+            if (posR > posL)
+                fn(groupIndex, m_itemArray.data() + posL, posR - posL);
+        });
+    }
+
+    template <typename Fn>
+    void parallelForEachItem(ThreadPool& pool, Fn&& fn, int chunkItemNum = 4096) const
+    {
+        parallelForEachChunk(pool, [&](int, const ClassType* items, int itemNum) {
+            for (int i = 0; i < itemNum; ++i)
+                fn(items[i]);
+        },
+            chunkItemNum);
+    }
+
+    template <typename Fn>
+    void parallelForEachItemInGroup(ThreadPool& pool, int groupIndex, Fn&& fn, int chunkItemNum = 4096) const
+    {
+        parallelForEachChunk(pool, [&](int, const ClassType* items, int itemNum) {
+            for (int i = 0; i < itemNum; ++i)
+                fn(items[i]);
+        },
+            chunkItemNum, groupIndex, groupIndex + 1);
+    }
+
+    // chunkFn(groupIndex, items, itemNum) -> R reduces one chunk,
+    // combine(R, R) -> R merges chunk results of the same group, in item order.
+    // Groups without items get identity.
+    template <typename R, typename ChunkFn, typename CombineFn>
+    std::array<R, MaxGroupNum> parallelReduceGroups(ThreadPool& pool, const R& identity,
+        ChunkFn&& chunkFn, CombineFn&& combine, int chunkItemNum = 4096) const
+    {
+        const auto chunks = makeChunks(chunkItemNum);
+        std::vector<R> chunkResults(chunks.size(), identity);
+        pool.parallelFor(chunks.size(), [&](int chunkIndex) {
+            const ItemChunk& chunk = chunks[chunkIndex];
+            chunkResults[chunkIndex] = chunkFn(chunk.groupIndex, m_itemArray.data() + chunk.itemBegin, chunk.itemEnd - chunk.itemBegin);
+        });
+
+        std::array<R, MaxGroupNum> groupResults;
+        groupResults.fill(identity);
+        for (size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex) {
+            R& groupResult = groupResults[chunks[chunkIndex].groupIndex];
+            groupResult = combine(groupResult, chunkResults[chunkIndex]);
+        }
+        return groupResults;
+    }
+
+    template <typename Projection = IdentityProjection>
+    auto parallelGroupSum(ThreadPool& pool, Projection proj = {}) const
+    {
+        using Value = std::decay_t<decltype(proj(std::declval<const ClassType&>()))>;
+        return parallelReduceGroups(pool, Value {}, [&](int, const ClassType* items, int itemNum) {
+            Value sum {};
+            for (int i = 0; i < itemNum; ++i)
+                sum += proj(items[i]);
+            return sum;
+        },
+            [](const Value& a, const Value& b) { return a + b; });
+    }
+
+    // {min, max} per group, empty groups get {numeric max, numeric lowest}
+    template <typename Projection = IdentityProjection>
+    auto parallelGroupMinMax(ThreadPool& pool, Projection proj = {}) const
+    {
+        using Value = std::decay_t<decltype(proj(std::declval<const ClassType&>()))>;
+        using MinMax = std::pair<Value, Value>;
+        const MinMax identity { std::numeric_limits<Value>::max(), std::numeric_limits<Value>::lowest() };
+        return parallelReduceGroups(pool, identity, [&](int, const ClassType* items, int itemNum) {
+            MinMax result = identity;
+            for (int i = 0; i < itemNum; ++i) {
+                const Value value = proj(items[i]);
+                result.first = std::min(result.first, value);
+                result.second = std::max(result.second, value);
+            }
+            return result;
+        },
+            [](const MinMax& a, const MinMax& b) { return MinMax { std::min(a.first, b.first), std::max(a.second, b.second) }; });
+    }
+
+    // number of items matching predicate, per group
+    template <typename Predicate>
+    std::array<int, MaxGroupNum> parallelGroupCount(ThreadPool& pool, Predicate&& predicate) const
+    {
+        return parallelReduceGroups(pool, 0, [&](int, const ClassType* items, int itemNum) {
+            int count = 0;
+            for (int i = 0; i < itemNum; ++i)
+                count += predicate(items[i]) ? 1 : 0;
+            return count;
+        },
+            [](int a, int b) { return a + b; });
+    }
+
+    int getGroupSize(int groupIndex) const { return groupPosR(groupIndex) - groupPosL(groupIndex); }
+
     void printGroupSplits() const
     {
         printf("Splits: ");
@@ -256,14 +575,141 @@ public:
     void addItemArray(int groupIndex, const ClassType* arr, int arrLength) { modifyData(groupIndex, arr, arrLength, false); }
     void addItem(int groupIndex, const ClassType& item) { modifyData(groupIndex, &item, 1, false); }
 
+    // append arrays[g] (lengths[g] items) to every group g at once, one backward pass, O(N + added)
+    void addItemArrays(const std::array<const ClassType*, MaxGroupNum>& arrays, const std::array<int, MaxGroupNum>& lengths)
+    {
+        int addedNum = 0;
+        for (int length : lengths)
+            addedNum += length;
+        if (addedNum == 0)
+            return;
+
+        m_itemArray.resize(m_itemArray.size() + addedNum);
+
+        int shift = addedNum; // items added to groups before current one
+        for (int groupIndex = MaxGroupNum - 1; groupIndex >= 0; --groupIndex) {
+            const int length = lengths[groupIndex];
+            shift -= length;
+
+            const int posL = groupPosL(groupIndex);
+            const int posR = (groupIndex == MaxGroupNum - 1) ? (int)m_itemArray.size() - addedNum : m_splits.at(groupIndex);
+            for (int i = 0; i < length; ++i)
+                m_itemArray[posR + shift + i] = arrays[groupIndex][i];
+            if (shift > 0)
+                for (int i = posR - 1; i >= posL; --i)
+                    m_itemArray[i + shift] = std::move(m_itemArray[i]);
+
+            if (groupIndex < MaxGroupNum - 1)
+                m_splits.at(groupIndex) += shift + length;
+        }
+    }
+
     void removeItem(int itemIndex)
     {
         offsetSplits(-1, getItemGroup(itemIndex, 0));
         m_itemArray.erase(m_itemArray.begin() + itemIndex);
     }
 
+    // Order inside groups is not kept, at most one move per group starting from item group.
+    // Hole is filled from the end of its group, that hole from the end of the next group and so on.
+    //
+    // A B C D E | F G H | I J    remove C
+    // A B E D | _ F G H | I J    E fills the hole, split 0 moves left
+    // A B E D | H F G | _ I J    H fills the hole, split 1 moves left
+    // A B E D | H F G | J I      J fills the hole, last slot is popped
+    void removeItemUnordered(int itemIndex)
+    {
+        assert(itemIndex >= 0 && itemIndex < m_itemArray.size());
+        const int groupIndexStart = getItemGroup(itemIndex, 0);
+
+        int hole = itemIndex;
+        for (int groupIndex = groupIndexStart; groupIndex < MaxGroupNum; ++groupIndex) {
+            const int groupLast = groupPosR(groupIndex) - 1; // == hole for empty group after previous shrink
+            if (groupLast != hole)
+                m_itemArray[hole] = std::move(m_itemArray[groupLast]);
+            hole = groupLast;
+            if (groupIndex < MaxGroupNum - 1)
+                m_splits.at(groupIndex)--;
+        }
+        assert(hole == m_itemArray.size() - 1);
+        m_itemArray.pop_back();
+    }
+
     void removeGroup(int groupIndex) { setItemArray(groupIndex, nullptr, 0); }
 
+    // header + splits in one write, items in another, no stdio buffering
+    bool saveToFile(const char* path) const
+    {
+        static_assert(std::is_trivially_copyable_v<ClassType>, "items are written as raw bytes");
+        static_assert(sizeof(int) == sizeof(int32_t));
+
+        const uint64_t itemsOffset = MultiGroupArrayFileHeader::calcItemsOffset(MaxGroupNum);
+        std::vector<uint8_t> head(itemsOffset, 0);
+
+        MultiGroupArrayFileHeader header {};
+        header.magic = MultiGroupArrayFileHeader::currentMagic;
+        header.itemSize = sizeof(ClassType);
+        header.itemAlign = alignof(ClassType);
+        header.groupNum = MaxGroupNum;
+        header.itemNum = m_itemArray.size();
+        header.itemsOffset = itemsOffset;
+        memcpy(head.data(), &header, sizeof(header));
+        memcpy(head.data() + sizeof(header), m_splits.data(), sizeof(m_splits));
+
+        FILE* f = fopen(path, "wb");
+        if (!f)
+            return false;
+        setvbuf(f, nullptr, _IONBF, 0);
+
+        bool ok = fwrite(head.data(), 1, head.size(), f) == head.size();
+        if (ok && !m_itemArray.empty())
+            ok = fwrite(m_itemArray.data(), sizeof(ClassType), m_itemArray.size(), f) == m_itemArray.size();
+        return (fclose(f) == 0) && ok;
+    }
+
+    // copy file content into this array, array is unchanged on failure
+    bool loadFromFile(const char* path)
+    {
+        static_assert(std::is_trivially_copyable_v<ClassType>, "items are read as raw bytes");
+
+        FILE* f = fopen(path, "rb");
+        if (!f)
+            return false;
+        setvbuf(f, nullptr, _IONBF, 0);
+
+        // file size first, items are resized only for an item number the file can hold
+        long fileSize = -1;
+        if (fseek(f, 0, SEEK_END) == 0)
+            fileSize = ftell(f);
+
+        MultiGroupArrayFileHeader header {};
+        std::array<int, MaxGroupNum - 1> splits;
+        bool ok = fileSize >= 0 && fseek(f, 0, SEEK_SET) == 0
+            && fread(&header, sizeof(header), 1, f) == 1
+            && header.isCompatible<ClassType, MaxGroupNum>()
+            && header.itemNum <= (uint64_t)std::numeric_limits<int>::max()
+            && header.itemsOffset <= (uint64_t)fileSize
+            && header.itemNum * sizeof(ClassType) <= (uint64_t)fileSize - header.itemsOffset
+            && fread(splits.data(), sizeof(splits), 1, f) == 1
+            && fseek(f, header.itemsOffset, SEEK_SET) == 0;
+
+        for (int i = 0; ok && i < MaxGroupNum - 1; ++i) // splits are monotonic and inside array
+            ok = splits[i] >= ((i == 0) ? 0 : splits[i - 1]) && splits[i] <= (int)header.itemNum;
+
+        std::vector<ClassType> items;
+        if (ok) {
+            items.resize(header.itemNum);
+            ok = fread(items.data(), sizeof(ClassType), items.size(), f) == items.size();
+        }
+        fclose(f);
+
+        if (ok) {
+            m_itemArray = std::move(items);
+            m_splits = splits;
+        }
+        return ok;
+    }
+
     constexpr int getCategoriesNum() const { return MaxGroupNum; }
 };
 
@@ -315,4 +761,101 @@ public:
     }
 };
 
+template <typename ClassType, int MaxGroupNum, typename Compare = std::less<>>
+class SortedMultiGroupArray : public MultiGroupArray<ClassType, MaxGroupNum> {
+    using Base = MultiGroupArray<ClassType, MaxGroupNum>;
+
+    Compare m_compare;
+
+    // unsorted modifications are hidden, they break the order inside a group
+    using Base::addItem;
+    using Base::addItemArray;
+    using Base::addItemArrays;
+    using Base::moveItemToGroup;
+    using Base::removeItemUnordered;
+    using Base::setItemArray;
+
+public:
+    SortedMultiGroupArray(Compare compare = {})
+        : m_compare(compare)
+    {
+    }
+
+    // counting sort bulk load, then every group is sorted
+    template <typename InputIt, typename GroupKeyFunc>
+    void assign(InputIt first, InputIt last, GroupKeyFunc groupKey, int threadNum = 1)
+    {
+        Base::assign(first, last, groupKey, threadNum);
+        for (int groupIndex = 0; groupIndex < MaxGroupNum; ++groupIndex)
+            std::stable_sort(groupBegin(groupIndex), groupEnd(groupIndex), m_compare);
+    }
+
+    ClassType* groupBegin(int groupIndex) { return this->m_itemArray.data() + this->groupPosL(groupIndex); }
+    ClassType* groupEnd(int groupIndex) { return this->m_itemArray.data() + this->groupPosR(groupIndex); }
+    const ClassType* groupBegin(int groupIndex) const { return this->m_itemArray.data() + this->groupPosL(groupIndex); }
+    const ClassType* groupEnd(int groupIndex) const { return this->m_itemArray.data() + this->groupPosR(groupIndex); }
+
+    // first item index in group not less than key, groupPosR if none
+    template <typename Key>
+    int lowerBound(int groupIndex, const Key& key) const
+    {
+        return std::lower_bound(groupBegin(groupIndex), groupEnd(groupIndex), key, m_compare) - this->m_itemArray.data();
+    }
+
+    // first item index in group greater than key, groupPosR if none
+    template <typename Key>
+    int upperBound(int groupIndex, const Key& key) const
+    {
+        return std::upper_bound(groupBegin(groupIndex), groupEnd(groupIndex), key, m_compare) - this->m_itemArray.data();
+    }
+
+    template <typename Key>
+    int findInGroup(int groupIndex, const Key& key) const
+    {
+        const int itemIndex = lowerBound(groupIndex, key);
+        if (itemIndex == this->groupPosR(groupIndex) || m_compare(key, this->m_itemArray[itemIndex]))
+            return INDEX_INVALID;
+        return itemIndex;
+    }
+
+    // group must be partitioned by predicate (true first), index of first false item
+    int partitionPointInGroup(int groupIndex, std::function<bool(const ClassType&)> predicate) const
+    {
+        return std::partition_point(groupBegin(groupIndex), groupEnd(groupIndex), predicate) - this->m_itemArray.data();
+    }
+
+    // after equal items, returns new item index
+    int insertSorted(int groupIndex, const ClassType& item)
+    {
+        const int itemIndex = upperBound(groupIndex, item);
+        this->insertData(groupIndex, itemIndex, &item, 1);
+        return itemIndex;
+    }
+
+    // sort new items, append them to the group with one tail shift, merge in place
+    void insertSortedArray(int groupIndex, const ClassType* arr, int arrLength)
+    {
+        if (arrLength <= 0)
+            return;
+
+        std::vector<ClassType> newItems(arr, arr + arrLength);
+        std::stable_sort(newItems.begin(), newItems.end(), m_compare);
+
+        const int oldGroupR = this->groupPosR(groupIndex);
+        this->insertData(groupIndex, oldGroupR, newItems.data(), arrLength);
+        std::inplace_merge(groupBegin(groupIndex), this->m_itemArray.data() + oldGroupR, groupEnd(groupIndex), m_compare);
+    }
+
+    // remove + sorted insert, returns new item index
+    int moveItemToGroupSorted(int itemIndex, int groupIndex)
+    {
+        if (itemIndex < 0 || itemIndex >= this->m_itemArray.size())
+            return INDEX_INVALID;
+
+        ClassType item = std::move(this->m_itemArray[itemIndex]);
+        this->removeItem(itemIndex);
+        return insertSorted(groupIndex, item);
+    }
+};
+
 #endif // MULTI_GROUP_ARRAY_H
@@ -0,0 +1,136 @@
+#ifndef MULTI_GROUP_ARRAY_VIEW_H
+#define MULTI_GROUP_ARRAY_VIEW_H
+
+#include "../utils/mapped_file.h"
+#include "multi_group_array.h"
+
+/* MultiGroupArrayView
+ *
+ * Read-only MultiGroupArray over a file written by MultiGroupArray::saveToFile.
+ * File is mapped with MappedFile, splits and items are read in place, nothing is copied,
+ * pages are loaded by the OS on first access.
+ *
+ * MultiGroupArrayView<Entity, 8> view;
+ * if (view.open("entities.mga"))
+ *     view.forEachItemInGroup(3, [](const Entity& e) { ... });
+ *
+ * Pointers from the view are valid until close() or destruction.
+ */
+
+template <typename ClassType, int MaxGroupNum>
+class MultiGroupArrayView {
+    static_assert(std::is_trivially_copyable_v<ClassType>, "items are mapped as raw bytes");
+    static_assert(alignof(ClassType) <= MultiGroupArrayFileHeader::itemsAlignment);
+
+    MappedFile m_file;
+
+    const int* m_splits {};
+    const ClassType* m_items {};
+    int m_itemNum {};
+
+public:
+    MultiGroupArrayView() = default;
+
+    MultiGroupArrayView(const MultiGroupArrayView&) = delete;
+    MultiGroupArrayView& operator=(const MultiGroupArrayView&) = delete;
+
+    bool open(const char* path)
+    {
+        close();
+        if (!m_file.open(path, MADV_WILLNEED) || m_file.size() < sizeof(MultiGroupArrayFileHeader)) {
+            close();
+            return false;
+        }
+
+        const uint8_t* bytes = m_file.data();
+        const auto* header = (const MultiGroupArrayFileHeader*)bytes;
+        const bool ok = header->isCompatible<ClassType, MaxGroupNum>()
+            && header->itemNum <= (uint64_t)std::numeric_limits<int>::max()
+            && header->itemsOffset + header->itemNum * sizeof(ClassType) <= m_file.size();
+        if (!ok) {
+            close();
+            return false;
+        }
+
+        m_splits = (const int*)(bytes + sizeof(MultiGroupArrayFileHeader));
+        m_items = (const ClassType*)(bytes + header->itemsOffset);
+        m_itemNum = header->itemNum;
+
+        for (int i = 0; i < MaxGroupNum - 1; ++i) {
+            if (m_splits[i] < groupPosL(i) || m_splits[i] > m_itemNum) {
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        m_file.close();
+        m_splits = nullptr;
+        m_items = nullptr;
+        m_itemNum = 0;
+    }
+
+    bool isOpen() const { return m_file.isOpen(); }
+    int size() const { return m_itemNum; }
+
+    int groupPosL(int groupIndex) const
+    {
+        assert(groupIndex >= 0 && groupIndex < MaxGroupNum);
+        return (groupIndex == 0) ? 0 : m_splits[groupIndex - 1];
+    }
+
+    int groupPosR(int groupIndex) const
+    {
+        assert(groupIndex >= 0 && groupIndex < MaxGroupNum);
+        return (groupIndex == MaxGroupNum - 1) ? m_itemNum : m_splits[groupIndex];
+    }
+
+    int getGroupSize(int groupIndex) const { return groupPosR(groupIndex) - groupPosL(groupIndex); }
+
+    int getItemGroup(int itemIndex, int startGroupIndex) const
+    {
+        while (startGroupIndex < MaxGroupNum) {
+            if (itemIndex < groupPosR(startGroupIndex))
+                break;
+            startGroupIndex++;
+        }
+        if (startGroupIndex == MaxGroupNum)
+            startGroupIndex = INDEX_INVALID;
+        return startGroupIndex;
+    }
+
+    const ClassType* getGroupStartPtr(int groupIndex) const
+    {
+        if (getGroupSize(groupIndex) == 0)
+            return nullptr;
+        return m_items + groupPosL(groupIndex);
+    }
+
+    const ClassType* getItemByIndex(int itemIndex) const
+    {
+        assert(itemIndex >= 0 && itemIndex < m_itemNum);
+        return m_items + itemIndex;
+    }
+
+    template <typename Fn>
+    void forEachItemInGroup(int groupIndex, Fn&& fn) const
+    {
+        for (int i = groupPosL(groupIndex); i < groupPosR(groupIndex); ++i)
+            fn(m_items[i]);
+    }
+
+    template <typename Fn>
+    void forEachItem(Fn&& fn) const
+    {
+        for (int i = 0; i < m_itemNum; ++i)
+            fn(m_items[i]);
+    }
+};
+
+template <int MaxGroupNum>
+using MultiGroupTextView = MultiGroupArrayView<char, MaxGroupNum>;
+
+#endif // MULTI_GROUP_ARRAY_VIEW_H
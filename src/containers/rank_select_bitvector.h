@@ -0,0 +1,158 @@
+#ifndef RANK_SELECT_BITVECTOR_H
+#define RANK_SELECT_BITVECTOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/* Static bit vector with rank and select, stored in an ArenaBuffer
+ *
+ * Header, words and index are addressed RELATIVE to the header, so it is relocatable.
+ * rank1(i): ones in [0, i). Cumulative count every 512 bits (8 words) + up to 8 popcounts, O(1).
+ * select1(k): position of the k-th one (k from 1). Every 4096-th one samples its block,
+ * then blocks are scanned from the sample, then words, then in-word select (pdep with BMI2).
+ * Index is 12.5% of bits + samples.
+ *
+ * size_t bvOffset = allocateBitVector(buf, bitNum);
+ * getBitVector(buf, bvOffset)->set(i) ...
+ * buildRankSelectIndex(buf, bvOffset); // after all bits are set
+ */
+
+struct RankSelectBitVector {
+    static constexpr size_t wordsPerBlock = 8;
+    static constexpr size_t bitsPerBlock = wordsPerBlock * 64;
+    static constexpr size_t onesPerSample = 4096;
+
+    uint64_t bitNum;
+    uint64_t oneNum;
+    uint64_t blockNum;
+    uint64_t sampleNum;
+    uint64_t wordsRel;
+    uint64_t blockRanksRel; // blockNum + 1 cumulative counts
+    uint64_t samplesRel; // block of the (s * onesPerSample + 1)-th one
+
+    const uint64_t* getWords() const { return (const uint64_t*)((const uint8_t*)this + wordsRel); }
+    const uint64_t* getBlockRanks() const { return (const uint64_t*)((const uint8_t*)this + blockRanksRel); }
+    const uint64_t* getSamples() const { return (const uint64_t*)((const uint8_t*)this + samplesRel); }
+    uint64_t* getWords() { return (uint64_t*)((uint8_t*)this + wordsRel); }
+
+    size_t getWordNum() const { return (bitNum + 63) / 64; }
+
+    bool get(size_t i) const { return getWords()[i / 64] >> (i % 64) & 1; }
+    void set(size_t i) { getWords()[i / 64] |= uint64_t(1) << (i % 64); }
+
+    size_t rank1(size_t i) const
+    {
+        assert(i <= bitNum);
+        const uint64_t* words = getWords();
+        const size_t word = i / 64;
+        size_t rank = getBlockRanks()[word / wordsPerBlock];
+        for (size_t w = word / wordsPerBlock * wordsPerBlock; w < word; ++w)
+            rank += __builtin_popcountll(words[w]);
+        if (i % 64)
+            rank += __builtin_popcountll(words[word] << (64 - i % 64));
+        return rank;
+    }
+
+    size_t rank0(size_t i) const { return i - rank1(i); }
+
+    // position of the k-th one, k in [1, oneNum]
+    size_t select1(size_t k) const
+    {
+        assert(k >= 1 && k <= oneNum);
+        const uint64_t* ranks = getBlockRanks();
+        size_t block = getSamples()[(k - 1) / onesPerSample];
+        while (ranks[block + 1] < k)
+            ++block;
+
+        const uint64_t* words = getWords();
+        size_t remaining = k - ranks[block];
+        size_t word = block * wordsPerBlock;
+        for (;; ++word) {
+            const size_t ones = __builtin_popcountll(words[word]);
+            if (ones >= remaining)
+                break;
+            remaining -= ones;
+        }
+        return word * 64 + selectInWord(words[word], remaining);
+    }
+
+    // position of the r-th set bit of w, r from 1
+    static size_t selectInWord(uint64_t w, size_t r)
+    {
+#ifdef __BMI2__
+        return __builtin_ctzll(_pdep_u64(uint64_t(1) << (r - 1), w));
+#else
+        for (size_t i = 1; i < r; ++i)
+            w &= w - 1;
+        return __builtin_ctzll(w);
+#endif
+    }
+};
+
+template <typename BufferType>
+RankSelectBitVector* getBitVector(BufferType& buf, size_t bvOffset) { return (RankSelectBitVector*)(buf.data + bvOffset); }
+
+template <typename BufferType>
+const RankSelectBitVector* getBitVector(const BufferType& buf, size_t bvOffset) { return (const RankSelectBitVector*)(buf.data + bvOffset); }
+
+// all bits are zero
+template <typename BufferType>
+size_t allocateBitVector(BufferType& buf, size_t bitNum)
+{
+    const size_t bvOffset = buf.template allocate<RankSelectBitVector>(1);
+    const size_t wordNum = (bitNum + 63) / 64;
+    const size_t wordsOffset = buf.template allocate<uint64_t>(wordNum);
+
+    RankSelectBitVector* bv = getBitVector(buf, bvOffset);
+    *bv = {};
+    bv->bitNum = bitNum;
+    bv->wordsRel = wordsOffset - bvOffset;
+    for (size_t i = 0; i < wordNum; ++i)
+        bv->getWords()[i] = 0;
+    return bvOffset;
+}
+
+template <typename BufferType>
+void buildRankSelectIndex(BufferType& buf, size_t bvOffset)
+{
+    using BV = RankSelectBitVector;
+    const size_t wordNum = getBitVector(buf, bvOffset)->getWordNum();
+    const size_t blockNum = (wordNum + BV::wordsPerBlock - 1) / BV::wordsPerBlock;
+    const size_t ranksOffset = buf.template allocate<uint64_t>(blockNum + 1);
+
+    BV* bv = getBitVector(buf, bvOffset);
+    const uint64_t* words = bv->getWords();
+    uint64_t* ranks = (uint64_t*)(buf.data + ranksOffset);
+    uint64_t ones = 0;
+    for (size_t block = 0; block < blockNum; ++block) {
+        ranks[block] = ones;
+        for (size_t w = block * BV::wordsPerBlock; w < std::min((block + 1) * BV::wordsPerBlock, wordNum); ++w)
+            ones += __builtin_popcountll(words[w]);
+    }
+    ranks[blockNum] = ones;
+
+    const size_t sampleNum = (ones + BV::onesPerSample - 1) / BV::onesPerSample;
+    const size_t samplesOffset = buf.template allocate<uint64_t>(sampleNum);
+    bv = getBitVector(buf, bvOffset);
+    uint64_t* samples = (uint64_t*)(buf.data + samplesOffset);
+    for (size_t s = 0, block = 0; s < sampleNum; ++s) {
+        const uint64_t k = s * BV::onesPerSample + 1;
+        while (ranks[block + 1] < k)
+            ++block;
+        samples[s] = block;
+    }
+
+    bv->oneNum = ones;
+    bv->blockNum = blockNum;
+    bv->sampleNum = sampleNum;
+    bv->blockRanksRel = ranksOffset - bvOffset;
+    bv->samplesRel = samplesOffset - bvOffset;
+}
+
+#endif // RANK_SELECT_BITVECTOR_H
@@ -0,0 +1,208 @@
+#ifndef BFS_H
+#define BFS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+#include "csr_graph.h"
+
+/* Direction-optimizing BFS (Beamer, Asanovic, Patterson)
+ *
+ * TOP-DOWN: every frontier vertex checks its out-edges, claims unvisited neighbors with CAS.
+ *           Cheap when the frontier is small.
+ * BOTTOM-UP: every unvisited vertex checks its in-edges and stops at the first parent in frontier.
+ *            Cheap when the frontier is a large part of the graph (low diameter, social graphs),
+ *            most edges are skipped.
+ *
+ * Switch to bottom-up when frontier edges > unexplored edges / alpha,
+ * back to top-down when frontier vertices < vertexNum / beta.
+ * Both directions sum out-degrees of newly found vertices into frontier edges, unexplored edges
+ * stay exact across switches.
+ *
+ * Top-down frontier is a vertex queue, bottom-up frontier is a bitmap.
+ * Bottom-up tasks own whole 64 bit words of the next bitmap, so no atomics there.
+ *
+ * ThreadPool pool;
+ * auto bfs = directionOptimizingBfs(pool, graph, graph, source); // undirected: in == out
+ * bfs.depths[v] // -1 if not reached
+ */
+
+// bitmap with relaxed atomic words, set() is safe from many threads
+class AtomicBitmap {
+    std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+    size_t m_wordNum {};
+
+public:
+    explicit AtomicBitmap(size_t bitNum)
+        : m_words(new std::atomic<uint64_t>[(bitNum + 63) / 64])
+        , m_wordNum((bitNum + 63) / 64)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < m_wordNum; ++i)
+            m_words[i].store(0, std::memory_order_relaxed);
+    }
+
+    bool get(size_t bit) const { return (m_words[bit / 64].load(std::memory_order_relaxed) >> (bit % 64)) & 1; }
+    void set(size_t bit) { m_words[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_relaxed); }
+
+    uint64_t getWord(size_t wordIndex) const { return m_words[wordIndex].load(std::memory_order_relaxed); }
+    void setWord(size_t wordIndex, uint64_t word) { m_words[wordIndex].store(word, std::memory_order_relaxed); }
+    size_t getWordNum() const { return m_wordNum; }
+
+    void swap(AtomicBitmap& other)
+    {
+        std::swap(m_words, other.m_words);
+        std::swap(m_wordNum, other.m_wordNum);
+    }
+};
+
+template <typename VertexT>
+struct BfsResult {
+    static constexpr VertexT noParent = std::numeric_limits<VertexT>::max();
+
+    std::vector<VertexT> parents; // noParent if not reached, source is its own parent
+    std::vector<int32_t> depths; // -1 if not reached
+};
+
+// outGraph: CSR (out-edges), inGraph: CSC (in-edges), the same pointer for undirected graphs
+template <typename Graph>
+BfsResult<typename Graph::Vertex> directionOptimizingBfs(ThreadPool& pool,
+    const Graph* outGraph, const Graph* inGraph, typename Graph::Vertex source,
+    int alpha = 15, int beta = 18)
+{
+    using Vertex = typename Graph::Vertex;
+    using Result = BfsResult<Vertex>;
+
+    const size_t vertexNum = outGraph->vertexNum;
+    assert(inGraph->vertexNum == vertexNum && source < vertexNum);
+
+    std::unique_ptr<std::atomic<Vertex>[]> parents(new std::atomic<Vertex>[vertexNum]);
+    std::vector<int32_t> depths(vertexNum, -1);
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            parents[v].store(Result::noParent, std::memory_order_relaxed);
+    });
+
+    const int taskNum = pool.getThreadNum() * 4;
+    std::vector<std::vector<Vertex>> taskQueues(taskNum);
+    std::vector<int64_t> taskCounters(taskNum);
+    std::vector<int64_t> taskEdges(taskNum); // out-degree sum of found vertices
+
+    AtomicBitmap frontierBits(vertexNum), nextBits(vertexNum);
+    std::vector<Vertex> queue { source };
+    parents[source] = source;
+    depths[source] = 0;
+
+    int64_t frontierEdges = outGraph->getDegree(source);
+    int64_t unexploredEdges = (int64_t)outGraph->edgeNum - frontierEdges;
+    size_t frontierSize = 1;
+    bool bottomUp = false;
+
+    for (int32_t depth = 1; frontierSize > 0; ++depth) {
+        if (!bottomUp && frontierEdges > unexploredEdges / alpha) {
+            bottomUp = true;
+            frontierBits.clear();
+            pool.parallelForRange(size_t(0), queue.size(), [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    frontierBits.set(queue[i]);
+            });
+        } else if (bottomUp && frontierSize < vertexNum / beta) {
+            bottomUp = false;
+            queue.clear();
+            for (size_t w = 0; w < frontierBits.getWordNum(); ++w)
+                for (uint64_t word = frontierBits.getWord(w); word; word &= word - 1)
+                    queue.push_back(w * 64 + __builtin_ctzll(word));
+        }
+
+        std::fill(taskCounters.begin(), taskCounters.end(), 0);
+        std::fill(taskEdges.begin(), taskEdges.end(), 0);
+
+        if (bottomUp) {
+            const size_t wordNum = frontierBits.getWordNum();
+            pool.parallelFor(taskNum, [&](int taskIndex) {
+                const size_t wordBegin = wordNum * taskIndex / taskNum;
+                const size_t wordEnd = wordNum * (taskIndex + 1) / taskNum;
+                int64_t found = 0;
+                int64_t foundEdges = 0;
+                for (size_t w = wordBegin; w < wordEnd; ++w) {
+                    uint64_t nextWord = 0;
+                    const size_t vEnd = std::min(vertexNum, w * 64 + 64);
+                    for (size_t v = w * 64; v < vEnd; ++v) {
+                        if (parents[v].load(std::memory_order_relaxed) != Result::noParent)
+                            continue;
+                        for (const Vertex* u = inGraph->neighborsBegin(v); u != inGraph->neighborsEnd(v); ++u) {
+                            if (frontierBits.get(*u)) {
+                                parents[v].store(*u, std::memory_order_relaxed);
+                                depths[v] = depth;
+                                nextWord |= uint64_t(1) << (v % 64);
+                                found++;
+                                foundEdges += outGraph->getDegree(v);
+                                break;
+                            }
+                        }
+                    }
+                    nextBits.setWord(w, nextWord);
+                }
+                taskCounters[taskIndex] = found;
+                taskEdges[taskIndex] = foundEdges;
+            });
+
+            frontierBits.swap(nextBits);
+            frontierSize = 0;
+            frontierEdges = 0;
+            for (int t = 0; t < taskNum; ++t) {
+                frontierSize += taskCounters[t];
+                frontierEdges += taskEdges[t];
+            }
+            unexploredEdges -= frontierEdges;
+        } else {
+            pool.parallelFor(taskNum, [&](int taskIndex) {
+                const size_t begin = queue.size() * taskIndex / taskNum;
+                const size_t end = queue.size() * (taskIndex + 1) / taskNum;
+                auto& next = taskQueues[taskIndex];
+                next.clear();
+                int64_t nextEdges = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    const Vertex u = queue[i];
+                    for (const Vertex* v = outGraph->neighborsBegin(u); v != outGraph->neighborsEnd(u); ++v) {
+                        Vertex expected = Result::noParent;
+                        if (parents[*v].load(std::memory_order_relaxed) == Result::noParent
+                            && parents[*v].compare_exchange_strong(expected, u, std::memory_order_relaxed)) {
+                            depths[*v] = depth;
+                            next.push_back(*v);
+                            nextEdges += outGraph->getDegree(*v);
+                        }
+                    }
+                }
+                taskEdges[taskIndex] = nextEdges;
+            });
+
+            queue.clear();
+            frontierEdges = 0;
+            for (int t = 0; t < taskNum; ++t) {
+                queue.insert(queue.end(), taskQueues[t].begin(), taskQueues[t].end());
+                frontierEdges += taskEdges[t];
+            }
+            frontierSize = queue.size();
+            unexploredEdges -= frontierEdges;
+        }
+    }
+
+    Result result;
+    result.parents.resize(vertexNum);
+    for (size_t v = 0; v < vertexNum; ++v)
+        result.parents[v] = parents[v].load(std::memory_order_relaxed);
+    result.depths = std::move(depths);
+    return result;
+}
+
+#endif // BFS_H
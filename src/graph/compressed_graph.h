@@ -0,0 +1,359 @@
+#ifndef COMPRESSED_GRAPH_H
+#define COMPRESSED_GRAPH_H
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include "../utils/varint.h"
+#include "csr_graph.h"
+
+/* Compressed adjacency lists
+ *
+ * Same idea as CsrGraph: header + arrays in one ArenaBuffer, offsets RELATIVE to the header.
+ * Neighbor ids are sorted, so they are stored as gaps, most gaps are small numbers.
+ *
+ * Row of v: degree, zigzag(n0 - v), n1 - n0, n2 - n1, ...
+ * byteOffsets[v] .. byteOffsets[v + 1] is the row of v in the byte stream.
+ * Offsets are uint32_t while the stream is under 4 GiB, uint64_t otherwise,
+ * 8 bytes per vertex would eat most of the saving on sparse graphs.
+ *
+ * VARINT: 7 bits per byte, high bit is "more bytes follow".
+ *
+ * GROUP VARINT: degree is a varint, gaps go in groups of 4 with one control byte,
+ * 2 bits per value = its byte length - 1.
+ *
+ *   control  v0 v1 v1 v2 v3 v3 v3     -> values are at fixed offsets known from control byte
+ *
+ * Decoding has no branch per byte: one 16 byte load, pshufb with a mask picked by control byte
+ * puts 4 values in 4 lanes, prefix sum turns gaps into ids (SSSE3, scalar fallback otherwise).
+ * Stream is padded so 16 byte loads never leave the arena allocation.
+ *
+ * CompressedGraph* cg = getCompressedGraph(buf, buildCompressedGraph(buf, csrGraph, CompressedGraph::GroupVarint));
+ * for (uint32_t n : cg->neighbors(v)) ...      // iterator decodes on the fly
+ * cg->forEachNeighbor(v, [](uint32_t n) {});   // whole row decode, faster
+ */
+
+namespace group_varint {
+
+inline int byteLength(uint32_t value) { return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4; }
+
+struct Tables {
+    uint8_t groupSize[256]; // control byte + values
+    uint8_t shuffle[256][16];
+
+    constexpr Tables()
+        : groupSize {}
+        , shuffle {}
+    {
+        for (int control = 0; control < 256; ++control) {
+            int src = 0;
+            for (int i = 0; i < 4; ++i) {
+                const int length = ((control >> (2 * i)) & 3) + 1;
+                for (int b = 0; b < 4; ++b)
+                    shuffle[control][i * 4 + b] = (b < length) ? src + b : 0x80; // 0x80 -> zero byte
+                src += length;
+            }
+            groupSize[control] = 1 + src;
+        }
+    }
+};
+
+inline constexpr Tables tables {};
+
+// encodes 4 values, returns end
+inline uint8_t* encodeGroup(uint8_t* out, const uint32_t values[4])
+{
+    uint8_t* control = out++;
+    *control = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int length = byteLength(values[i]);
+        *control |= (length - 1) << (2 * i);
+        for (int b = 0; b < length; ++b)
+            *out++ = uint8_t(values[i] >> (8 * b));
+    }
+    return out;
+}
+
+inline size_t groupSize(const uint32_t values[4])
+{
+    return 1 + byteLength(values[0]) + byteLength(values[1]) + byteLength(values[2]) + byteLength(values[3]);
+}
+
+// gaps -> ids, prev is the id before the group, needs 16 readable bytes after in
+inline const uint8_t* decodeGroup(const uint8_t* in, uint32_t prev, uint32_t out[4])
+{
+    const uint8_t control = *in;
+#ifdef __SSSE3__
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)(in + 1));
+    __m128i values = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i*)tables.shuffle[control]));
+    values = _mm_add_epi32(values, _mm_slli_si128(values, 4)); // prefix sum of 4 lanes
+    values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+    values = _mm_add_epi32(values, _mm_set1_epi32(prev));
+    _mm_storeu_si128((__m128i*)out, values);
+#else
+    const uint8_t* src = in + 1;
+    for (int i = 0; i < 4; ++i) {
+        const int length = ((control >> (2 * i)) & 3) + 1;
+        uint32_t word;
+        memcpy(&word, src, sizeof(word));
+        word &= (length == 4) ? 0xffffffffu : ((1u << (8 * length)) - 1);
+        prev += word;
+        out[i] = prev;
+        src += length;
+    }
+#endif
+    return in + tables.groupSize[control];
+}
+
+} // namespace group_varint
+
+struct CompressedGraph {
+    using Vertex = uint32_t;
+
+    enum Encoding : uint32_t {
+        Varint,
+        GroupVarint,
+    };
+
+    static constexpr size_t streamPadding = 16;
+
+    Vertex vertexNum;
+    Encoding encoding;
+    uint32_t offsetSize; // 4 or 8
+    uint32_t unused;
+    uint64_t edgeNum;
+    uint64_t byteOffsetsRel;
+    uint64_t streamRel;
+
+    uint64_t getByteOffset(Vertex v) const
+    {
+        const uint8_t* byteOffsets = (const uint8_t*)this + byteOffsetsRel;
+        return offsetSize == 4 ? ((const uint32_t*)byteOffsets)[v] : ((const uint64_t*)byteOffsets)[v];
+    }
+    const uint8_t* getStream() const { return (const uint8_t*)this + streamRel; }
+    const uint8_t* rowBegin(Vertex v) const { return getStream() + getByteOffset(v); }
+
+    uint64_t getStreamBytes() const { return getByteOffset(vertexNum); }
+
+    uint32_t getDegree(Vertex v) const
+    {
+        uint64_t degree;
+        varint::decode(rowBegin(v), degree);
+        return degree;
+    }
+
+    template <typename Fn>
+    void forEachNeighbor(Vertex v, Fn&& fn) const
+    {
+        uint64_t degree;
+        const uint8_t* in = varint::decode(rowBegin(v), degree);
+        if (degree == 0)
+            return;
+
+        if (encoding == Varint) {
+            uint64_t value;
+            in = varint::decode(in, value);
+            uint32_t neighbor = int64_t(v) + varint::unzigzag(value);
+            fn(neighbor);
+            for (uint64_t i = 1; i < degree; ++i) {
+                in = varint::decode(in, value);
+                neighbor += value;
+                fn(neighbor);
+            }
+            return;
+        }
+
+        uint64_t first;
+        in = varint::decode(in, first);
+        uint32_t neighbor = int64_t(v) + varint::unzigzag(first);
+        fn(neighbor);
+
+        uint32_t decoded[4];
+        for (uint64_t i = 1; i < degree; i += 4) {
+            in = group_varint::decodeGroup(in, neighbor, decoded);
+            const uint64_t count = std::min<uint64_t>(4, degree - i);
+            for (uint64_t k = 0; k < count; ++k)
+                fn(decoded[k]);
+            neighbor = decoded[3];
+        }
+    }
+
+    // decodes one neighbor (or group of 4) at a time
+    class NeighborIterator {
+        const CompressedGraph* m_graph {};
+        const uint8_t* m_in {};
+        uint64_t m_remaining {}; // including current
+        uint32_t m_current {};
+        uint32_t m_group[4] {};
+        int m_groupPos = 4;
+
+        void decodeNext()
+        {
+            if (m_graph->encoding == Varint) {
+                uint64_t gap;
+                m_in = varint::decode(m_in, gap);
+                m_current += gap;
+                return;
+            }
+            if (m_groupPos == 4) {
+                m_in = group_varint::decodeGroup(m_in, m_current, m_group);
+                m_groupPos = 0;
+            }
+            m_current = m_group[m_groupPos++];
+        }
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint32_t*;
+        using reference = uint32_t;
+
+        NeighborIterator() = default;
+        NeighborIterator(const CompressedGraph* graph, Vertex v)
+            : m_graph(graph)
+        {
+            m_in = varint::decode(graph->rowBegin(v), m_remaining);
+            if (m_remaining) {
+                uint64_t first;
+                m_in = varint::decode(m_in, first);
+                m_current = int64_t(v) + varint::unzigzag(first);
+            }
+        }
+
+        uint32_t operator*() const { return m_current; }
+        NeighborIterator& operator++()
+        {
+            if (--m_remaining)
+                decodeNext();
+            return *this;
+        }
+        bool operator==(const NeighborIterator& other) const { return m_remaining == other.m_remaining; }
+        bool operator!=(const NeighborIterator& other) const { return m_remaining != other.m_remaining; }
+    };
+
+    struct NeighborRange {
+        NeighborIterator first;
+        NeighborIterator begin() const { return first; }
+        NeighborIterator end() const { return {}; }
+    };
+
+    NeighborRange neighbors(Vertex v) const { return { NeighborIterator(this, v) }; }
+};
+
+inline CompressedGraph* getCompressedGraph(uint8_t* bufData, size_t graphOffset) { return (CompressedGraph*)(bufData + graphOffset); }
+
+template <typename BufferType>
+CompressedGraph* getCompressedGraph(BufferType& buf, size_t graphOffset) { return getCompressedGraph(buf.data, graphOffset); }
+
+// bytes of one row, neighbors must be sorted
+template <typename VertexT>
+size_t encodedRowSize(CompressedGraph::Encoding encoding, VertexT v, const VertexT* neighbors, size_t degree)
+{
+    size_t size = varint::encodedSize(degree);
+    if (degree == 0)
+        return size;
+
+    size += varint::encodedSize(varint::zigzag(int64_t(neighbors[0]) - int64_t(v)));
+    if (encoding == CompressedGraph::Varint) {
+        for (size_t i = 1; i < degree; ++i)
+            size += varint::encodedSize(neighbors[i] - neighbors[i - 1]);
+        return size;
+    }
+
+    for (size_t i = 1; i < degree; i += 4) {
+        uint32_t gaps[4] = {};
+        for (size_t k = 0; k < 4 && i + k < degree; ++k)
+            gaps[k] = neighbors[i + k] - neighbors[i + k - 1];
+        size += group_varint::groupSize(gaps);
+    }
+    return size;
+}
+
+template <typename VertexT>
+uint8_t* encodeRow(uint8_t* out, CompressedGraph::Encoding encoding, VertexT v, const VertexT* neighbors, size_t degree)
+{
+    out = varint::encode(out, degree);
+    if (degree == 0)
+        return out;
+
+    out = varint::encode(out, varint::zigzag(int64_t(neighbors[0]) - int64_t(v)));
+    if (encoding == CompressedGraph::Varint) {
+        for (size_t i = 1; i < degree; ++i)
+            out = varint::encode(out, neighbors[i] - neighbors[i - 1]);
+        return out;
+    }
+
+    for (size_t i = 1; i < degree; i += 4) {
+        uint32_t gaps[4] = {};
+        for (size_t k = 0; k < 4 && i + k < degree; ++k)
+            gaps[k] = neighbors[i + k] - neighbors[i + k - 1];
+        out = group_varint::encodeGroup(out, gaps);
+    }
+    return out;
+}
+
+// offsets[v + 1] = offsets[v] + row size, returns stream bytes
+template <typename OffsetT, typename Graph>
+uint64_t writeRowOffsets(OffsetT* byteOffsets, const Graph* graph, CompressedGraph::Encoding encoding)
+{
+    byteOffsets[0] = 0;
+    for (size_t v = 0; v < graph->vertexNum; ++v)
+        byteOffsets[v + 1] = byteOffsets[v] + encodedRowSize(encoding, (typename Graph::Vertex)v, graph->neighborsBegin(v), graph->getDegree(v));
+    return byteOffsets[graph->vertexNum];
+}
+
+// compressed copy of a CSR graph with sorted neighbors (weights are dropped), returns graph offset in buf
+template <typename Graph, typename BufferType>
+size_t buildCompressedGraph(BufferType& buf, const Graph* graph, CompressedGraph::Encoding encoding)
+{
+    static_assert(sizeof(typename Graph::Vertex) <= sizeof(uint32_t));
+
+    // pass 1: sizes, offset width is known only from the total
+    uint64_t streamBytes = 0;
+    for (size_t v = 0; v < graph->vertexNum; ++v) {
+        assert(std::is_sorted(graph->neighborsBegin(v), graph->neighborsEnd(v)));
+        streamBytes += encodedRowSize(encoding, (typename Graph::Vertex)v, graph->neighborsBegin(v), graph->getDegree(v));
+    }
+    const uint32_t offsetSize = streamBytes <= UINT32_MAX ? 4 : 8;
+
+    const size_t graphOffset = buf.template allocate<CompressedGraph>(1);
+    size_t byteOffsetsOffset;
+    if (offsetSize == 4) {
+        byteOffsetsOffset = buf.template allocate<uint32_t>((size_t)graph->vertexNum + 1);
+        writeRowOffsets((uint32_t*)(buf.data + byteOffsetsOffset), graph, encoding);
+    } else {
+        byteOffsetsOffset = buf.template allocate<uint64_t>((size_t)graph->vertexNum + 1);
+        writeRowOffsets((uint64_t*)(buf.data + byteOffsetsOffset), graph, encoding);
+    }
+
+    const size_t streamOffset = buf.template allocate<uint8_t>(streamBytes + CompressedGraph::streamPadding);
+    memset(buf.data + streamOffset + streamBytes, 0, CompressedGraph::streamPadding);
+
+    CompressedGraph* compressed = getCompressedGraph(buf, graphOffset);
+    compressed->vertexNum = graph->vertexNum;
+    compressed->encoding = encoding;
+    compressed->offsetSize = offsetSize;
+    compressed->unused = 0;
+    compressed->edgeNum = graph->edgeNum;
+    compressed->byteOffsetsRel = byteOffsetsOffset - graphOffset;
+    compressed->streamRel = streamOffset - graphOffset;
+
+    // pass 2: encode
+    uint8_t* stream = buf.data + streamOffset;
+    for (size_t v = 0; v < graph->vertexNum; ++v) {
+        uint8_t* rowEnd = encodeRow(stream + compressed->getByteOffset(v), encoding, (typename Graph::Vertex)v, graph->neighborsBegin(v), graph->getDegree(v));
+        assert(rowEnd == stream + compressed->getByteOffset(v + 1));
+        (void)rowEnd;
+    }
+    return graphOffset;
+}
+
+#endif // COMPRESSED_GRAPH_H
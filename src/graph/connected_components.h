@@ -0,0 +1,202 @@
+#ifndef CONNECTED_COMPONENTS_H
+#define CONNECTED_COMPONENTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+#include "csr_graph.h"
+
+/* Connected components, O(V) extra memory: one atomic parent per vertex
+ *
+ * Both variants hook the higher root under the lower one with CAS,
+ * so the final label of a vertex is the smallest vertex id of its component.
+ * Directed graphs are treated as undirected: pass inGraph (CSC) to see in-edges too,
+ * or nullptr for symmetric graphs.
+ *
+ * UNION-FIND: every edge is united in parallel, find does path halving with CAS.
+ *
+ * AFFOREST (Sutton, Ben-Nun, Barak): Shiloach-Vishkin style hooking on a subgraph first.
+ * 1. Link only the first neighborRounds neighbors of every vertex, compress.
+ * 2. Sample vertices, the most frequent label is most likely the giant component.
+ * 3. Link remaining edges, skipping vertices already in the giant component.
+ * On real graphs most vertices are in the giant component, so most edges are never touched.
+ *
+ * auto labels = connectedComponentsAfforest(pool, graph, nullptr);
+ * size_t componentNum = countComponents(labels);
+ */
+
+template <typename VertexT>
+class ConcurrentUnionFind {
+    std::unique_ptr<std::atomic<VertexT>[]> m_parents;
+    size_t m_size;
+
+public:
+    explicit ConcurrentUnionFind(size_t size)
+        : m_parents(new std::atomic<VertexT>[size])
+        , m_size(size)
+    {
+        for (size_t v = 0; v < size; ++v)
+            m_parents[v].store(v, std::memory_order_relaxed);
+    }
+
+    size_t size() const { return m_size; }
+
+    VertexT find(VertexT v)
+    {
+        for (;;) {
+            VertexT parent = m_parents[v].load(std::memory_order_relaxed);
+            if (parent == v)
+                return v;
+            VertexT grandParent = m_parents[parent].load(std::memory_order_relaxed);
+            if (parent != grandParent) // path halving, losing the race is fine
+                m_parents[v].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+            v = grandParent;
+        }
+    }
+
+    // true if a and b were in different sets
+    bool unite(VertexT a, VertexT b)
+    {
+        for (;;) {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return false;
+            if (a < b)
+                std::swap(a, b);
+            VertexT expected = a; // a is still a root
+            if (m_parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                return true;
+        }
+    }
+
+    VertexT getParent(VertexT v) const { return m_parents[v].load(std::memory_order_relaxed); }
+};
+
+template <typename Graph>
+std::vector<typename Graph::Vertex> connectedComponentsUnionFind(ThreadPool& pool, const Graph* graph, const Graph* inGraph)
+{
+    using Vertex = typename Graph::Vertex;
+    const size_t vertexNum = graph->vertexNum;
+    ConcurrentUnionFind<Vertex> sets(vertexNum);
+
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t u = begin; u < end; ++u) {
+            for (const Vertex* v = graph->neighborsBegin(u); v != graph->neighborsEnd(u); ++v)
+                sets.unite(u, *v);
+            if (inGraph)
+                for (const Vertex* v = inGraph->neighborsBegin(u); v != inGraph->neighborsEnd(u); ++v)
+                    sets.unite(u, *v);
+        }
+    });
+
+    std::vector<Vertex> labels(vertexNum);
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            labels[v] = sets.find(v);
+    });
+    return labels;
+}
+
+template <typename Graph>
+std::vector<typename Graph::Vertex> connectedComponentsAfforest(ThreadPool& pool, const Graph* graph, const Graph* inGraph,
+    int neighborRounds = 2, int sampleNum = 1024)
+{
+    using Vertex = typename Graph::Vertex;
+    const size_t vertexNum = graph->vertexNum;
+
+    std::unique_ptr<std::atomic<Vertex>[]> components(new std::atomic<Vertex>[vertexNum]);
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            components[v].store(v, std::memory_order_relaxed);
+    });
+
+    auto comp = [&](Vertex v) { return components[v].load(std::memory_order_relaxed); };
+
+    auto link = [&](Vertex u, Vertex v) {
+        Vertex p1 = comp(u);
+        Vertex p2 = comp(v);
+        while (p1 != p2) {
+            const Vertex high = std::max(p1, p2);
+            const Vertex low = std::min(p1, p2);
+            Vertex highParent = comp(high);
+            if (highParent == low) // already hooked by someone else
+                break;
+            if (highParent == high && components[high].compare_exchange_strong(highParent, low, std::memory_order_relaxed))
+                break;
+            p1 = comp(comp(high));
+            p2 = comp(low);
+        }
+    };
+
+    auto compress = [&] {
+        pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v)
+                while (comp(v) != comp(comp(v)))
+                    components[v].store(comp(comp(v)), std::memory_order_relaxed);
+        });
+    };
+
+    // 1. sparse subgraph: first neighbors only
+    for (int round = 0; round < neighborRounds; ++round) {
+        pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+            for (size_t u = begin; u < end; ++u)
+                if ((size_t)round < graph->getDegree(u))
+                    link(u, graph->neighborsBegin(u)[round]);
+        });
+        compress();
+    }
+
+    // 2. most frequent label of a sample
+    Vertex giant = 0;
+    if (vertexNum > 0) {
+        std::unordered_map<Vertex, int> counts;
+        std::mt19937 random(27491095);
+        std::uniform_int_distribution<size_t> distribution(0, vertexNum - 1);
+        for (int i = 0; i < sampleNum; ++i)
+            counts[comp(distribution(random))]++;
+
+        int bestCount = 0;
+        for (const auto& [label, count] : counts)
+            if (count > bestCount) {
+                bestCount = count;
+                giant = label;
+            }
+    }
+
+    // 3. rest of the edges, giant component is skipped
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t u = begin; u < end; ++u) {
+            if (comp(u) == giant)
+                continue;
+            const Vertex* neighbors = graph->neighborsBegin(u);
+            for (size_t i = neighborRounds; i < graph->getDegree(u); ++i)
+                link(u, neighbors[i]);
+            if (inGraph) // first rounds covered out-edges only
+                for (const Vertex* v = inGraph->neighborsBegin(u); v != inGraph->neighborsEnd(u); ++v)
+                    link(u, *v);
+        }
+    });
+    compress();
+
+    std::vector<Vertex> labels(vertexNum);
+    for (size_t v = 0; v < vertexNum; ++v)
+        labels[v] = comp(v);
+    return labels;
+}
+
+template <typename VertexT>
+size_t countComponents(const std::vector<VertexT>& labels)
+{
+    size_t componentNum = 0;
+    for (size_t v = 0; v < labels.size(); ++v)
+        componentNum += (labels[v] == v) ? 1 : 0; // label is the smallest vertex of component
+    return componentNum;
+}
+
+#endif // CONNECTED_COMPONENTS_H
@@ -0,0 +1,266 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "../containers/arena_buffer.h"
+
+/* Compressed Sparse Row graph
+ *
+ * 1. Header and all arrays are in one ArenaBuffer: Header, offsets[V + 1], adjacency[E], weights[E].
+ * 2. Arrays are addressed by offsets RELATIVE to the HEADER, so the graph is relocatable,
+ *    can be memcpy-ed or dumped to file and read back as is (like tree.bin).
+ * 3. Neighbors of v: adjacency[offsets[v] .. offsets[v + 1]), weights are parallel to adjacency.
+ *
+ *            offsets   0   2   3   5
+ *                      |   |   |   |
+ *          adjacency   1 2 2 0 1
+ *
+ * CSC (in-edges) is CSR of the transposed graph: build with transposed = true.
+ *
+ * Builder is streaming: edge source is called twice, first to count degrees, then to fill,
+ * no intermediate edge list is stored.
+ *
+ * auto buf = std::make_unique<ArenaBuffer<(1 << 26)>>();
+ * using Graph = CsrGraph<uint32_t, uint32_t, float>;
+ * size_t graphOffset = buildCsrGraph<Graph>(*buf, vertexNum, [&](auto emit) {
+ *     for (auto& e : edges)
+ *         emit(e.from, e.to, e.weight);
+ * }, true);
+ * const Graph* graph = getCsrGraph<Graph>(*buf, graphOffset);
+ */
+
+template <typename VertexT, typename WeightT>
+struct GraphEdge {
+    VertexT from, to;
+    WeightT weight;
+};
+
+template <typename VertexT = uint32_t, typename EdgeT = uint32_t, typename WeightT = float>
+struct CsrGraph {
+    using Vertex = VertexT;
+    using Edge = EdgeT;
+    using Weight = WeightT;
+
+    VertexT vertexNum;
+    EdgeT edgeNum;
+    uint64_t offsetsRel;
+    uint64_t adjacencyRel;
+    uint64_t weightsRel; // 0 if graph is not weighted
+
+    template <typename T>
+    T* atRel(uint64_t rel) { return (T*)((uint8_t*)this + rel); }
+    template <typename T>
+    const T* atRel(uint64_t rel) const { return (const T*)((const uint8_t*)this + rel); }
+
+    EdgeT* getOffsets() { return atRel<EdgeT>(offsetsRel); }
+    VertexT* getAdjacency() { return atRel<VertexT>(adjacencyRel); }
+    WeightT* getWeights() { return weightsRel ? atRel<WeightT>(weightsRel) : nullptr; }
+    const EdgeT* getOffsets() const { return atRel<EdgeT>(offsetsRel); }
+    const VertexT* getAdjacency() const { return atRel<VertexT>(adjacencyRel); }
+    const WeightT* getWeights() const { return weightsRel ? atRel<WeightT>(weightsRel) : nullptr; }
+
+    bool isWeighted() const { return weightsRel != 0; }
+
+    EdgeT getDegree(VertexT v) const { return getOffsets()[v + 1] - getOffsets()[v]; }
+    const VertexT* neighborsBegin(VertexT v) const { return getAdjacency() + getOffsets()[v]; }
+    const VertexT* neighborsEnd(VertexT v) const { return getAdjacency() + getOffsets()[v + 1]; }
+    const WeightT* weightsBegin(VertexT v) const { return getWeights() + getOffsets()[v]; }
+
+    // fn(neighbor, weight), weight is 1 for not weighted graph
+    template <typename Fn>
+    void forEachNeighbor(VertexT v, Fn&& fn) const
+    {
+        const EdgeT begin = getOffsets()[v], end = getOffsets()[v + 1];
+        const VertexT* adjacency = getAdjacency();
+        const WeightT* weights = getWeights();
+        for (EdgeT e = begin; e < end; ++e)
+            fn(adjacency[e], weights ? weights[e] : WeightT(1));
+    }
+};
+
+template <typename Graph, typename BufferType>
+Graph* getCsrGraph(BufferType& buf, size_t graphOffset) { return (Graph*)(buf.data + graphOffset); }
+
+template <typename Graph, typename BufferType>
+const Graph* getCsrGraph(const BufferType& buf, size_t graphOffset) { return (const Graph*)(buf.data + graphOffset); }
+
+// header and uninitialized arrays, offsets are zeroed
+template <typename Graph, typename BufferType>
+size_t allocateCsrGraph(BufferType& buf, typename Graph::Vertex vertexNum, typename Graph::Edge edgeNum, bool weighted)
+{
+    using Vertex = typename Graph::Vertex;
+    using Edge = typename Graph::Edge;
+    using Weight = typename Graph::Weight;
+
+    const size_t graphOffset = buf.template allocate<Graph>(1);
+    const size_t offsetsOffset = buf.template allocate<Edge>((size_t)vertexNum + 1);
+    const size_t adjacencyOffset = buf.template allocate<Vertex>(edgeNum);
+    const size_t weightsOffset = weighted ? buf.template allocate<Weight>(edgeNum) : 0;
+
+    Graph* graph = getCsrGraph<Graph>(buf, graphOffset);
+    graph->vertexNum = vertexNum;
+    graph->edgeNum = edgeNum;
+    graph->offsetsRel = offsetsOffset - graphOffset;
+    graph->adjacencyRel = adjacencyOffset - graphOffset;
+    graph->weightsRel = weighted ? weightsOffset - graphOffset : 0;
+    std::fill(graph->getOffsets(), graph->getOffsets() + (size_t)vertexNum + 1, Edge(0));
+    return graphOffset;
+}
+
+// true if allocateCsrGraph(buf, vertexNum, edgeNum, weighted) fits in the rest of buf,
+// ArenaBuffer::allocate only asserts. 64-bit math, counts too large for the arena never overflow.
+template <typename Graph, typename BufferType>
+bool csrGraphFits(const BufferType& buf, uint64_t vertexNum, uint64_t edgeNum, bool weighted)
+{
+    using Vertex = typename Graph::Vertex;
+    using Edge = typename Graph::Edge;
+    using Weight = typename Graph::Weight;
+
+    const uint64_t capacity = sizeof(buf.data);
+    if (vertexNum >= capacity || edgeNum >= capacity) // every item is at least a byte
+        return false;
+
+    const uint64_t alignSlack = alignof(Graph) + alignof(Edge) + alignof(Vertex) + alignof(Weight);
+    const uint64_t bytes = sizeof(Graph) + (vertexNum + 1) * sizeof(Edge) + edgeNum * sizeof(Vertex)
+        + (weighted ? edgeNum * sizeof(Weight) : 0) + alignSlack;
+    return buf.size + bytes < capacity;
+}
+
+// degrees must be in offsets[v + 1], turns them into row starts
+template <typename Graph>
+void csrDegreesToOffsets(Graph* graph)
+{
+    auto* offsets = graph->getOffsets();
+    for (size_t v = 0; v < graph->vertexNum; ++v)
+        offsets[v + 1] += offsets[v];
+}
+
+// after fill with offsets[v]++ as cursor offsets[v] holds row end, move back by one row
+template <typename Graph>
+void csrRestoreOffsets(Graph* graph)
+{
+    auto* offsets = graph->getOffsets();
+    for (size_t v = graph->vertexNum; v > 0; --v)
+        offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+}
+
+// sort adjacency rows of [vertexBegin, vertexEnd) by neighbor id, weights are permuted with it
+template <typename Graph>
+void sortCsrNeighbors(Graph* graph, size_t vertexBegin = 0, size_t vertexEnd = SIZE_MAX)
+{
+    using Vertex = typename Graph::Vertex;
+    using Weight = typename Graph::Weight;
+
+    auto* offsets = graph->getOffsets();
+    auto* adjacency = graph->getAdjacency();
+    auto* weights = graph->getWeights();
+    std::vector<std::pair<Vertex, Weight>> row;
+
+    vertexEnd = std::min<size_t>(vertexEnd, graph->vertexNum);
+    for (size_t v = vertexBegin; v < vertexEnd; ++v) {
+        if (!weights) {
+            std::sort(adjacency + offsets[v], adjacency + offsets[v + 1]);
+            continue;
+        }
+        row.clear();
+        for (auto e = offsets[v]; e < offsets[v + 1]; ++e)
+            row.push_back({ adjacency[e], weights[e] });
+        std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < row.size(); ++i) {
+            adjacency[offsets[v] + i] = row[i].first;
+            weights[offsets[v] + i] = row[i].second;
+        }
+    }
+}
+
+// edgeSource(emit) must call emit(from, to, weight) for every edge, it is called twice.
+// transposed = true builds CSC: rows are edge targets, adjacency holds sources.
+// Returns graph offset in buf.
+template <typename Graph, typename BufferType, typename EdgeSource>
+size_t buildCsrGraph(BufferType& buf, typename Graph::Vertex vertexNum, EdgeSource&& edgeSource,
+    bool weighted, bool transposed = false, bool sortNeighbors = true)
+{
+    using Vertex = typename Graph::Vertex;
+    using Edge = typename Graph::Edge;
+    using Weight = typename Graph::Weight;
+
+    // pass 1: degrees, kept in a temporary array as arena size is not known yet
+    std::vector<Edge> degrees((size_t)vertexNum + 1, 0);
+    Edge edgeNum = 0;
+    edgeSource([&](Vertex from, Vertex to, Weight) {
+        assert(from < vertexNum && to < vertexNum);
+        degrees[(transposed ? to : from) + 1]++;
+        edgeNum++;
+    });
+
+    const size_t graphOffset = allocateCsrGraph<Graph>(buf, vertexNum, edgeNum, weighted);
+    Graph* graph = getCsrGraph<Graph>(buf, graphOffset);
+    std::copy(degrees.begin(), degrees.end(), graph->getOffsets());
+    degrees = {};
+    csrDegreesToOffsets(graph);
+
+    // pass 2: fill, offsets[row] is the write cursor
+    Edge* offsets = graph->getOffsets();
+    Vertex* adjacency = graph->getAdjacency();
+    Weight* weights = graph->getWeights();
+    edgeSource([&](Vertex from, Vertex to, Weight weight) {
+        const Vertex row = transposed ? to : from;
+        const Edge e = offsets[row]++;
+        adjacency[e] = transposed ? from : to;
+        if (weights)
+            weights[e] = weight;
+    });
+    csrRestoreOffsets(graph);
+
+    if (sortNeighbors)
+        sortCsrNeighbors(graph);
+    return graphOffset;
+}
+
+template <typename Graph, typename BufferType>
+size_t buildCsrGraphFromEdges(BufferType& buf, typename Graph::Vertex vertexNum,
+    const GraphEdge<typename Graph::Vertex, typename Graph::Weight>* edges, size_t edgeNum,
+    bool weighted, bool transposed = false, bool sortNeighbors = true)
+{
+    return buildCsrGraph<Graph>(buf, vertexNum, [&](auto emit) {
+        for (size_t i = 0; i < edgeNum; ++i)
+            emit(edges[i].from, edges[i].to, edges[i].weight);
+    },
+        weighted, transposed, sortNeighbors);
+}
+
+// CSC of an existing CSR graph (or CSR of a CSC), appended to dstBuf
+template <typename Graph, typename BufferType>
+size_t buildTransposedCsrGraph(BufferType& dstBuf, const Graph* graph, bool sortNeighbors = true)
+{
+    return buildCsrGraph<Graph>(dstBuf, graph->vertexNum, [&](auto emit) {
+        for (typename Graph::Vertex v = 0; v < graph->vertexNum; ++v)
+            graph->forEachNeighbor(v, [&](typename Graph::Vertex n, typename Graph::Weight w) { emit(v, n, w); });
+    },
+        graph->isWeighted(), true, sortNeighbors);
+}
+
+template <typename Graph>
+void printCsrGraph(const Graph* graph, size_t maxVertexNum = 16)
+{
+    printf("Vertices: %zu  Edges: %zu\n", (size_t)graph->vertexNum, (size_t)graph->edgeNum);
+    for (size_t v = 0; v < std::min<size_t>(graph->vertexNum, maxVertexNum); ++v) {
+        printf("%zu:", v);
+        graph->forEachNeighbor(v, [&](typename Graph::Vertex n, typename Graph::Weight w) {
+            if (graph->isWeighted())
+                printf(" %zu(%g)", (size_t)n, (double)w);
+            else
+                printf(" %zu", (size_t)n);
+        });
+        printf("\n");
+    }
+}
+
+#endif // CSR_GRAPH_H
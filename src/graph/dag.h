@@ -0,0 +1,305 @@
+#ifndef DAG_H
+#define DAG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+#include "csr_graph.h"
+
+/* DAG of tasks
+ *
+ * Dag header, successor CsrGraph and in-degrees are in one ArenaBuffer,
+ * addressed RELATIVE to the Dag header, so the whole DAG is relocatable (like DenseTreeNode trees).
+ * Edge from -> to means "to" depends on "from".
+ *
+ * topologicalOrder: Kahn's algorithm, O(V + E).
+ *
+ * runDag: work stealing executor, node callback runs as soon as all its dependencies finished.
+ *   - every node has an atomic counter of unfinished dependencies
+ *   - finishing a node decrements its successors, the one that reaches 0 is pushed to own deque
+ *   - worker pops own deque from the bottom (LIFO, cache hot successors),
+ *     when empty steals from the top of other deques (Chase-Lev deque)
+ *   - deques start small and double when full, memory follows the ready width, not node number
+ *   - worker that finds no work after a few sweeps parks on a condition variable,
+ *     pushes wake it only when someone is parked
+ *   No mutex on the hot path.
+ *
+ * size_t dagOffset = buildDag<Graph>(buf, nodeNum, [&](auto emit) { emit(a, b, 0); ... });
+ * const auto* dag = getDag<Graph>(buf, dagOffset);
+ * runDag(pool, dag, [&](uint32_t node) { tasks[node](); });
+ */
+
+template <typename Graph>
+struct Dag {
+    using Vertex = typename Graph::Vertex;
+
+    uint64_t successorsRel;
+    uint64_t inDegreesRel;
+    uint32_t acyclic;
+
+    const Graph* getSuccessors() const { return (const Graph*)((const uint8_t*)this + successorsRel); }
+    const uint32_t* getInDegrees() const { return (const uint32_t*)((const uint8_t*)this + inDegreesRel); }
+    Vertex getNodeNum() const { return getSuccessors()->vertexNum; }
+};
+
+template <typename Graph, typename BufferType>
+const Dag<Graph>* getDag(const BufferType& buf, size_t dagOffset) { return (const Dag<Graph>*)(buf.data + dagOffset); }
+
+// false if graph has a cycle, order holds the nodes that could be ordered
+template <typename Graph>
+bool topologicalOrder(const Graph* successors, const uint32_t* inDegrees, std::vector<typename Graph::Vertex>& order)
+{
+    using Vertex = typename Graph::Vertex;
+    const size_t nodeNum = successors->vertexNum;
+
+    std::vector<uint32_t> pending(inDegrees, inDegrees + nodeNum);
+    order.clear();
+    order.reserve(nodeNum);
+    for (size_t v = 0; v < nodeNum; ++v)
+        if (pending[v] == 0)
+            order.push_back(v);
+
+    for (size_t head = 0; head < order.size(); ++head) // order is the queue
+        for (const Vertex* s = successors->neighborsBegin(order[head]); s != successors->neighborsEnd(order[head]); ++s)
+            if (--pending[*s] == 0)
+                order.push_back(*s);
+
+    return order.size() == nodeNum;
+}
+
+template <typename Graph>
+bool topologicalOrder(const Dag<Graph>* dag, std::vector<typename Graph::Vertex>& order)
+{
+    return topologicalOrder(dag->getSuccessors(), dag->getInDegrees(), order);
+}
+
+// edgeSource(emit) calls emit(from, to, weight) for every dependency, it is called twice
+template <typename Graph, typename BufferType, typename EdgeSource>
+size_t buildDag(BufferType& buf, typename Graph::Vertex nodeNum, EdgeSource&& edgeSource)
+{
+    const size_t dagOffset = buf.template allocate<Dag<Graph>>(1);
+    const size_t graphOffset = buildCsrGraph<Graph>(buf, nodeNum, edgeSource, false, false, false);
+    const size_t inDegreesOffset = buf.template allocate<uint32_t>(nodeNum);
+
+    const Graph* successors = getCsrGraph<Graph>(buf, graphOffset);
+    uint32_t* inDegrees = (uint32_t*)(buf.data + inDegreesOffset);
+    std::fill(inDegrees, inDegrees + nodeNum, 0);
+    for (size_t e = 0; e < successors->edgeNum; ++e)
+        inDegrees[successors->getAdjacency()[e]]++;
+
+    Dag<Graph>* dag = (Dag<Graph>*)(buf.data + dagOffset);
+    dag->successorsRel = graphOffset - dagOffset;
+    dag->inDegreesRel = inDegreesOffset - dagOffset;
+
+    std::vector<typename Graph::Vertex> order;
+    dag->acyclic = topologicalOrder(successors, inDegrees, order);
+    return dagOffset;
+}
+
+// Chase-Lev deque, owner: push/take at bottom, others: steal at top.
+// Full push doubles the ring, old rings live until the deque is destroyed, a thief may still read one.
+template <typename T>
+class WorkStealingDeque {
+    struct Ring {
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+
+        explicit Ring(int64_t size)
+            : mask(size - 1)
+            , items(new std::atomic<T>[size])
+        {
+        }
+
+        std::atomic<T>& at(int64_t index) { return items[index & mask]; }
+    };
+
+    std::atomic<int64_t> m_top { 0 };
+    std::atomic<int64_t> m_bottom { 0 };
+    std::atomic<Ring*> m_ring;
+    std::vector<std::unique_ptr<Ring>> m_rings; // owner only
+
+    Ring* grow(Ring* ring, int64_t top, int64_t bottom)
+    {
+        m_rings.emplace_back(new Ring((ring->mask + 1) * 2));
+        Ring* grown = m_rings.back().get();
+        for (int64_t i = top; i < bottom; ++i)
+            grown->at(i).store(ring->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_ring.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+public:
+    explicit WorkStealingDeque(size_t capacity = 64)
+    {
+        int64_t size = 1;
+        while (size < (int64_t)capacity)
+            size <<= 1;
+        m_rings.emplace_back(new Ring(size));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    void push(T item)
+    {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        if (bottom - top > ring->mask)
+            ring = grow(ring, top, bottom);
+        ring->at(bottom).store(item, std::memory_order_relaxed);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    bool take(T& item)
+    {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+
+        if (top > bottom) { // empty
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = ring->at(bottom).load(std::memory_order_relaxed);
+        if (top == bottom) { // last item, race with thieves
+            const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    bool steal(T& item)
+    {
+        int64_t top = m_top.load(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom)
+            return false;
+
+        Ring* ring = m_ring.load(std::memory_order_acquire);
+        item = ring->at(top).load(std::memory_order_relaxed);
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+};
+
+// fn(node) for every node, dependencies first, on all pool threads. false if DAG has a cycle.
+template <typename Graph, typename Fn>
+bool runDag(ThreadPool& pool, const Dag<Graph>* dag, Fn&& fn)
+{
+    using Vertex = typename Graph::Vertex;
+    static constexpr int spinSweepNum = 16; // failed steal sweeps before parking
+
+    if (!dag->acyclic)
+        return false;
+
+    const Graph* successors = dag->getSuccessors();
+    const size_t nodeNum = successors->vertexNum;
+    const int workerNum = pool.getThreadNum();
+
+    size_t rootNum = 0;
+    for (size_t v = 0; v < nodeNum; ++v)
+        rootNum += dag->getInDegrees()[v] == 0;
+
+    std::unique_ptr<std::atomic<uint32_t>[]> pending(new std::atomic<uint32_t>[nodeNum]);
+    std::vector<std::unique_ptr<WorkStealingDeque<Vertex>>> deques;
+    for (int w = 0; w < workerNum; ++w)
+        deques.emplace_back(new WorkStealingDeque<Vertex>(std::max<size_t>(64, rootNum / workerNum + 1)));
+
+    int rootIndex = 0;
+    for (size_t v = 0; v < nodeNum; ++v) {
+        pending[v].store(dag->getInDegrees()[v], std::memory_order_relaxed);
+        if (dag->getInDegrees()[v] == 0)
+            deques[rootIndex++ % workerNum]->push(v);
+    }
+
+    std::atomic<size_t> remaining { nodeNum };
+
+    // parking: sleeper reads wakeEpoch, announces itself, sweeps once more, waits for the epoch to change.
+    // Pusher publishes the item, then checks sleeperNum (seq_cst on both sides), so either the last sweep
+    // sees the item or the pusher sees the sleeper and bumps the epoch.
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+    std::atomic<uint64_t> wakeEpoch { 0 };
+    std::atomic<int> sleeperNum { 0 };
+
+    auto wake = [&](bool all) {
+        {
+            std::lock_guard<std::mutex> lock(parkMutex);
+            wakeEpoch.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (all)
+            parkCondition.notify_all();
+        else
+            parkCondition.notify_one();
+    };
+
+    pool.parallelFor(workerNum, [&](int worker) {
+        WorkStealingDeque<Vertex>& own = *deques[worker];
+        int victim = worker;
+
+        auto findWork = [&](Vertex& node) {
+            if (own.take(node))
+                return true;
+            for (int attempt = 1; attempt < workerNum; ++attempt) {
+                victim = (victim + 1) % workerNum;
+                if (victim != worker && deques[victim]->steal(node))
+                    return true;
+            }
+            return false;
+        };
+
+        int failedSweepNum = 0;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            Vertex node;
+            if (!findWork(node)) {
+                if (++failedSweepNum < spinSweepNum) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                const uint64_t epoch = wakeEpoch.load(std::memory_order_seq_cst);
+                sleeperNum.fetch_add(1, std::memory_order_seq_cst);
+                const bool found = findWork(node);
+                if (!found) {
+                    std::unique_lock<std::mutex> lock(parkMutex);
+                    parkCondition.wait(lock, [&] {
+                        return wakeEpoch.load(std::memory_order_relaxed) != epoch || remaining.load(std::memory_order_acquire) == 0;
+                    });
+                }
+                sleeperNum.fetch_sub(1, std::memory_order_relaxed);
+                if (!found)
+                    continue;
+            }
+            failedSweepNum = 0;
+
+            fn(node);
+
+            int pushedNum = 0;
+            for (const Vertex* s = successors->neighborsBegin(node); s != successors->neighborsEnd(node); ++s)
+                if (pending[*s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    own.push(*s);
+                    pushedNum++;
+                }
+
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                wake(true); // done, release all sleepers
+                continue;
+            }
+            if (pushedNum > 0) {
+                std::atomic_thread_fence(std::memory_order_seq_cst); // pushes before the sleeper check
+                if (sleeperNum.load(std::memory_order_seq_cst) > 0)
+                    wake(pushedNum > 1);
+            }
+        }
+    });
+    return true;
+}
+
+#endif // DAG_H
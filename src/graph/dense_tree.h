@@ -6,6 +6,12 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "../containers/arena_buffer.h"
+#include "../utils/varint.h"
 
 /* Dense tree
  *
@@ -18,35 +24,6 @@
  * Reallocation, rearrange tree is not supported yet.
  */
 
-template <int alignSize>
-inline constexpr size_t alignToSize(size_t p)
-{
-    static_assert(((alignSize - 1) & alignSize) == 0); // is pow of 2
-    constexpr size_t alignMask = (alignSize - 1);
-    return (p + alignMask) & ~alignMask;
-}
-
-// pre-allocated buffer
-template <int Capacity>
-class ArenaBuffer {
-
-public:
-    size_t size {};
-    uint8_t data[Capacity] {};
-
-    // return offset from data aligned to T
-    template <typename T>
-    size_t allocate(size_t num)
-    {
-        const size_t alignedPtrStart = alignToSize<alignof(T)>((size_t)data + size);
-        const size_t alignedOffsetStart = alignedPtrStart - (size_t)data;
-        size = alignedOffsetStart + num * sizeof(T);
-
-        assert(size < sizeof(data));
-        return alignedOffsetStart;
-    }
-};
-
 // node with relative pointers (aka uint8_t, uint16_t)
 template <typename DataType, typename RelPtrType>
 struct alignas(alignof(DataType)) DenseTreeNode {
@@ -78,14 +55,27 @@ RelPtrType makeRandomTree(BufferType& buf,
     return nodeOffset;
 }
 
-// Draw tree structure
-template <typename BufferType, typename Node_t, typename RelPtrType>
-void printTree(BufferType& buf,
-    RelPtrType nodeOffset, int level, size_t childBitfield)
+// writePayload(buf) allocates and fills node data right after the node, returns node offset or -1
+template <typename BufferType, typename Node_t, typename RelPtrType, typename WritePayload>
+RelPtrType makeTree(BufferType& buf, int level, WritePayload&& writePayload)
 {
-    if (nodeOffset == (RelPtrType)-1)
-        return;
+    if (level == 0)
+        return (RelPtrType)-1;
+
+    RelPtrType nodeOffset = buf.template allocate<Node_t>(1);
+    writePayload(buf);
 
+    const RelPtrType l = makeTree<BufferType, Node_t, RelPtrType>(buf, level - 1, writePayload);
+    const RelPtrType r = makeTree<BufferType, Node_t, RelPtrType>(buf, level - 1, writePayload);
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    nodePtr->l = l;
+    nodePtr->r = r;
+    return nodeOffset;
+}
+
+// tree drawing prefix of a node, childBitfield bit i is set if ancestor at level - i is a right child
+inline void printTreePrefix(int level, size_t childBitfield)
+{
     for (int i = level - 1; i >= 0; --i) {
         if (childBitfield >> i & 0b1) {
             if (childBitfield & 1 && i == 0)
@@ -99,6 +89,17 @@ void printTree(BufferType& buf,
                 printf("|  ");
         }
     }
+}
+
+// Draw tree structure
+template <typename BufferType, typename Node_t, typename RelPtrType>
+void printTree(BufferType& buf,
+    RelPtrType nodeOffset, int level, size_t childBitfield)
+{
+    if (nodeOffset == (RelPtrType)-1)
+        return;
+
+    printTreePrefix(level, childBitfield);
 
     Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
     printf("%s\n", nodePtr->getData());
@@ -109,4 +110,340 @@ void printTree(BufferType& buf,
     printTree<BufferType, Node_t>(buf, nodePtr->r, level + 1, childBitfield);
 }
 
+/* Implicit left child
+ *
+ * Pre-order layout already puts the left child right after the parent data: Node, Data, LeftSubtree, RightSubtree.
+ * So only the right child is stored, as a forward distance in bytes from the node,
+ * one RelPtrType per node instead of two: link = (distance << 1) | hasLeft, distance 0 is no right child.
+ * Left child address is computed from the payload size, strings are null terminated.
+ * Distances are relative to the node, so any subtree is copyable on its own.
+ */
+
+template <typename DataType>
+inline size_t getPayloadSize(const DataType*) { return sizeof(DataType); }
+inline size_t getPayloadSize(const char* str) { return strlen(str) + 1; }
+
+template <typename DataType, typename RelPtrType>
+struct alignas(alignof(DataType)) ImplicitDenseTreeNode {
+    RelPtrType link;
+
+    DataType* getData() { return (DataType*)((size_t)this + sizeof(ImplicitDenseTreeNode)); }
+
+    bool hasLeft() const { return link & 1; }
+    bool hasRight() const { return link >> 1; }
+
+    // left node follows the data, aligned like nodes are allocated
+    ImplicitDenseTreeNode* getLeft()
+    {
+        const size_t dataEnd = (size_t)getData() + getPayloadSize(getData());
+        return hasLeft() ? (ImplicitDenseTreeNode*)alignToSize<alignof(ImplicitDenseTreeNode)>(dataEnd) : nullptr;
+    }
+
+    ImplicitDenseTreeNode* getRight() { return hasRight() ? (ImplicitDenseTreeNode*)((size_t)this + (link >> 1)) : nullptr; }
+};
+
+// writePayload(buf) allocates and fills node data right after the node, returns node offset or -1
+template <typename BufferType, typename Node_t, typename RelPtrType, typename WritePayload>
+size_t makeImplicitTree(BufferType& buf, int level, WritePayload&& writePayload)
+{
+    if (level == 0)
+        return (size_t)-1;
+
+    const size_t nodeOffset = buf.template allocate<Node_t>(1);
+    writePayload(buf);
+
+    const size_t leftOffset = makeImplicitTree<BufferType, Node_t, RelPtrType>(buf, level - 1, writePayload);
+    const size_t rightOffset = makeImplicitTree<BufferType, Node_t, RelPtrType>(buf, level - 1, writePayload);
+
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    const size_t rightDistance = rightOffset == (size_t)-1 ? 0 : rightOffset - nodeOffset;
+    assert(rightDistance <= ((RelPtrType)-1 >> 1)); // distance with the flag must fit RelPtrType
+    nodePtr->link = (RelPtrType)(rightDistance << 1 | (leftOffset != (size_t)-1));
+    assert(leftOffset == (size_t)-1 || (Node_t*)(buf.data + leftOffset) == nodePtr->getLeft());
+    return nodeOffset;
+}
+
+// Same tree as makeRandomTree for the same rand() state
+template <typename BufferType, typename Node_t, typename RelPtrType>
+size_t makeRandomImplicitTree(BufferType& buf,
+    int level, char** strings, int stringNum)
+{
+    return makeImplicitTree<BufferType, Node_t, RelPtrType>(buf, level, [&](BufferType& b) {
+        auto str = strings[rand() % stringNum];
+        strcpy((char*)b.data + b.template allocate<char>(strlen(str) + 1), str);
+    });
+}
+
+// fn(node, level) in pre-order
+template <typename Node_t, typename Fn>
+void forEachImplicitNode(Node_t* node, Fn&& fn, int level = 0)
+{
+    for (; node; node = node->getRight(), ++level) { // right child is a loop, left is a recursion
+        fn(node, level);
+        if (node->hasLeft())
+            forEachImplicitNode(node->getLeft(), fn, level + 1);
+    }
+}
+
+inline void printPayload(const char* str) { printf("%s\n", str); }
+template <typename DataType>
+inline void printPayload(const DataType* value)
+{
+    if constexpr (std::is_floating_point_v<DataType>)
+        printf("%g\n", (double)*value);
+    else
+        printf("%lld\n", (long long)*value);
+}
+
+template <typename Node_t>
+void printImplicitTree(Node_t* node, int level, size_t childBitfield)
+{
+    if (!node)
+        return;
+
+    printTreePrefix(level, childBitfield);
+    printPayload(node->getData());
+
+    childBitfield <<= 1;
+    printImplicitTree(node->getLeft(), level + 1, childBitfield);
+    childBitfield |= 1;
+    printImplicitTree(node->getRight(), level + 1, childBitfield);
+}
+
+/* Interned payloads
+ *
+ * Node stores offset of its data instead of the data, identical payloads are stored once.
+ * PayloadInterner is a hash index of payloads already written to the arena, one per alignment,
+ * keys are string_views of arena memory, so it is only needed during construction.
+ * Data offsets are RELATIVE to the BUFFER BEGIN, like l and r.
+ */
+
+template <typename DataType, typename RelPtrType>
+struct InternedDenseTreeNode {
+    RelPtrType l, r, data;
+
+    template <typename BufferType>
+    DataType* getData(BufferType& buf) { return (DataType*)(buf.data + data); }
+};
+
+template <typename RelPtrType>
+class PayloadInterner {
+    static constexpr int alignNum = 8; // 1 .. 128 bytes
+
+    // [log2 alignment], copy aligned to 8 also serves 1, 2 and 4
+    std::unordered_map<std::string_view, RelPtrType> m_offsets[alignNum];
+
+public:
+    size_t getUniqueNum() const
+    {
+        size_t uniqueNum = 0;
+        for (const auto& offsets : m_offsets)
+            uniqueNum += offsets.size();
+        return uniqueNum;
+    }
+
+    // offset of equal bytes already in buf with at least AlignType alignment, or of a new copy
+    template <typename AlignType = char, typename BufferType>
+    RelPtrType intern(BufferType& buf, const void* bytes, size_t size)
+    {
+        constexpr int alignIndex = __builtin_ctz(alignof(AlignType));
+        static_assert(alignIndex < alignNum);
+
+        const std::string_view key((const char*)bytes, size);
+        for (int i = alignIndex; i < alignNum; ++i) {
+            const auto it = m_offsets[i].find(key);
+            if (it != m_offsets[i].end() && ((size_t)buf.data + it->second) % alignof(AlignType) == 0)
+                return it->second;
+        }
+
+        const size_t offset = buf.template allocate<AlignType>((size + sizeof(AlignType) - 1) / sizeof(AlignType));
+        assert(offset == (RelPtrType)offset);
+        memcpy(buf.data + offset, bytes, size);
+        m_offsets[alignIndex].emplace(std::string_view((const char*)buf.data + offset, size), (RelPtrType)offset);
+        return (RelPtrType)offset;
+    }
+
+    template <typename BufferType>
+    RelPtrType intern(BufferType& buf, const char* str) { return intern(buf, str, strlen(str) + 1); }
+};
+
+// Same tree as makeRandomTree for the same rand() state, repeated strings are stored once
+template <typename BufferType, typename Node_t, typename RelPtrType>
+RelPtrType makeRandomInternedTree(BufferType& buf,
+    int level, char** strings, int stringNum, PayloadInterner<RelPtrType>& interner)
+{
+    if (level == 0)
+        return (RelPtrType)-1;
+
+    RelPtrType nodeOffset = buf.template allocate<Node_t>(1);
+    const RelPtrType dataOffset = interner.intern(buf, strings[rand() % stringNum]);
+
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    nodePtr->data = dataOffset;
+    nodePtr->l = makeRandomInternedTree<BufferType, Node_t, RelPtrType>(buf, level - 1, strings, stringNum, interner);
+    nodePtr->r = makeRandomInternedTree<BufferType, Node_t, RelPtrType>(buf, level - 1, strings, stringNum, interner);
+    return nodeOffset;
+}
+
+template <typename BufferType, typename Node_t, typename RelPtrType>
+void printInternedTree(BufferType& buf,
+    RelPtrType nodeOffset, int level, size_t childBitfield)
+{
+    if (nodeOffset == (RelPtrType)-1)
+        return;
+
+    printTreePrefix(level, childBitfield);
+
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    printPayload(nodePtr->getData(buf));
+
+    childBitfield <<= 1;
+    printInternedTree<BufferType, Node_t>(buf, nodePtr->l, level + 1, childBitfield);
+    childBitfield |= 1;
+    printInternedTree<BufferType, Node_t>(buf, nodePtr->r, level + 1, childBitfield);
+}
+
+/* Length-prefixed payloads
+ *
+ * Payload header follows the node: varint of (byteSize << 1 | outOfLine).
+ *   inline:      Node, Header, [padding to payload alignment], Bytes
+ *   out of line: Node, Header, RelPtrType data offset RELATIVE to the BUFFER BEGIN (interned, stored once), unaligned
+ * Size is known from the header, no strlen, strings are stored without null terminator.
+ * Payloads up to inlineLimit bytes are inline, larger ones are interned.
+ */
+
+template <typename T>
+struct Span {
+    T* data {};
+    size_t size {};
+
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    T& operator[](size_t i) const { return data[i]; }
+    bool empty() const { return size == 0; }
+};
+
+template <typename RelPtrType>
+struct SizedDenseTreeNode {
+    RelPtrType l, r;
+
+    struct Payload {
+        const uint8_t* bytes;
+        size_t byteSize;
+    };
+
+    const uint8_t* getHeader() const { return (const uint8_t*)this + sizeof(SizedDenseTreeNode); }
+
+    size_t getByteSize() const
+    {
+        uint64_t header;
+        varint::decode(getHeader(), header);
+        return header >> 1;
+    }
+
+    bool isInline() const
+    {
+        uint64_t header;
+        varint::decode(getHeader(), header);
+        return !(header & 1);
+    }
+
+    // payload bytes and size, one header decode, inline bytes are aligned to alignof(T)
+    template <typename T, typename BufferType>
+    Payload getPayload(const BufferType& buf) const
+    {
+        uint64_t header;
+        const uint8_t* next = varint::decode(getHeader(), header);
+        if (!(header & 1))
+            return { (const uint8_t*)alignToSize<alignof(T)>((size_t)next), header >> 1 };
+        RelPtrType offset;
+        memcpy(&offset, next, sizeof(offset));
+        return { buf.data + offset, header >> 1 };
+    }
+
+    template <typename T, typename BufferType>
+    const uint8_t* getBytes(const BufferType& buf) const { return getPayload<T>(buf).bytes; }
+
+    template <typename T, typename BufferType>
+    Span<const T> getSpan(const BufferType& buf) const
+    {
+        const Payload payload = getPayload<T>(buf);
+        return { (const T*)payload.bytes, payload.byteSize / sizeof(T) };
+    }
+
+    template <typename BufferType>
+    std::string_view getString(const BufferType& buf) const
+    {
+        const Payload payload = getPayload<char>(buf);
+        return { (const char*)payload.bytes, payload.byteSize };
+    }
+
+    // same interned offset is a fast path, equal bytes may still live at different offsets
+    template <typename T, typename BufferType>
+    bool payloadEquals(const BufferType& buf, const SizedDenseTreeNode& other) const
+    {
+        const Payload a = getPayload<T>(buf);
+        const Payload b = other.getPayload<T>(buf);
+        return a.byteSize == b.byteSize && (a.bytes == b.bytes || memcmp(a.bytes, b.bytes, a.byteSize) == 0);
+    }
+};
+
+// call right after the node is allocated
+template <typename T, typename BufferType, typename RelPtrType>
+void writeSizedPayload(BufferType& buf, PayloadInterner<RelPtrType>& interner, const T* values, size_t count, size_t inlineLimit)
+{
+    const size_t byteSize = count * sizeof(T);
+    const bool outOfLine = byteSize > inlineLimit;
+    uint8_t header[10];
+    const size_t headerSize = varint::encode(header, byteSize << 1 | outOfLine) - header;
+
+    // header goes right after the node, interned data may be allocated after it
+    const size_t headerOffset = buf.template allocate<uint8_t>(headerSize + (outOfLine ? sizeof(RelPtrType) : 0));
+    memcpy(buf.data + headerOffset, header, headerSize);
+    if (outOfLine) {
+        const RelPtrType dataOffset = interner.template intern<T>(buf, values, byteSize);
+        memcpy(buf.data + headerOffset + headerSize, &dataOffset, sizeof(dataOffset));
+    } else if (byteSize)
+        memcpy(buf.data + buf.template allocate<T>(count), values, byteSize);
+}
+
+// Same tree as makeRandomTree for the same rand() state
+template <typename BufferType, typename Node_t, typename RelPtrType>
+RelPtrType makeRandomSizedTree(BufferType& buf,
+    int level, char** strings, int stringNum, PayloadInterner<RelPtrType>& interner, size_t inlineLimit = 8)
+{
+    if (level == 0)
+        return (RelPtrType)-1;
+
+    RelPtrType nodeOffset = buf.template allocate<Node_t>(1);
+    const char* str = strings[rand() % stringNum];
+    writeSizedPayload(buf, interner, str, strlen(str), inlineLimit);
+
+    const RelPtrType l = makeRandomSizedTree<BufferType, Node_t, RelPtrType>(buf, level - 1, strings, stringNum, interner, inlineLimit);
+    const RelPtrType r = makeRandomSizedTree<BufferType, Node_t, RelPtrType>(buf, level - 1, strings, stringNum, interner, inlineLimit);
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    nodePtr->l = l;
+    nodePtr->r = r;
+    return nodeOffset;
+}
+
+template <typename BufferType, typename Node_t, typename RelPtrType>
+void printSizedTree(BufferType& buf,
+    RelPtrType nodeOffset, int level, size_t childBitfield)
+{
+    if (nodeOffset == (RelPtrType)-1)
+        return;
+
+    printTreePrefix(level, childBitfield);
+
+    Node_t* nodePtr = (Node_t*)(buf.data + nodeOffset);
+    const std::string_view str = nodePtr->getString(buf);
+    printf("%.*s\n", (int)str.size(), str.data());
+
+    childBitfield <<= 1;
+    printSizedTree<BufferType, Node_t>(buf, nodePtr->l, level + 1, childBitfield);
+    childBitfield |= 1;
+    printSizedTree<BufferType, Node_t>(buf, nodePtr->r, level + 1, childBitfield);
+}
+
 #endif // DENSE_TREE_H
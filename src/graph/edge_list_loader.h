@@ -0,0 +1,387 @@
+#ifndef EDGE_LIST_LOADER_H
+#define EDGE_LIST_LOADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "../utils/mapped_file.h"
+#include "../utils/thread_pool.h"
+#include "csr_graph.h"
+
+/* Edge list loader
+ *
+ * TEXT: one edge per line "from to [weight]", whitespace separated.
+ *   SNAP:          '#' comments, "# Nodes: N Edges: M" gives vertex number.
+ *   Matrix Market: "%%MatrixMarket matrix coordinate ... [symmetric]" header, '%' comments,
+ *                  "rows cols nnz" size line, 1-based ids, symmetric files get both directions.
+ *
+ * BINARY: EdgeListBinaryHeader + records of { uint32 from, uint32 to [, float weight] }.
+ *
+ * File is mmap-ed and split into one chunk per task, text chunks start after a '\n',
+ * so every line belongs to exactly one chunk. Integers are parsed by hand, no sscanf/strtol.
+ * Graph is built straight into the arena, count-then-fill:
+ *   1. parse, count degrees (relaxed atomic increments)
+ *   2. prefix sum -> offsets, parse again, place every edge by atomic row cursor
+ *   3. sort rows in parallel (cursor order depends on thread timing)
+ * Unless vertex number is given or fixed by the Matrix Market size line, there is one more quick
+ * pass for the max id (SNAP "# Nodes:" is only a lower bound, real files have ids past it).
+ * Out of range ids and lines with a single number fail the load.
+ *
+ * size_t graphOffset;
+ * if (loadTextEdgeList<Graph>(pool, buf, "soc-LiveJournal1.txt", graphOffset))
+ *     const Graph* graph = getCsrGraph<Graph>(buf, graphOffset);
+ */
+
+struct EdgeListBinaryHeader {
+    static constexpr uint32_t currentMagic = 0x31474445; // "EDG1"
+
+    uint32_t magic;
+    uint32_t weighted; // records have float weight
+    uint64_t vertexNum;
+    uint64_t edgeNum;
+};
+
+namespace edge_list_parser {
+
+inline bool isDigit(char c) { return (unsigned)(c - '0') < 10; }
+
+inline const char* skipLine(const char* p, const char* end)
+{
+    const char* newline = (const char*)memchr(p, '\n', end - p);
+    return newline ? newline + 1 : end;
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == ','))
+        p++;
+    return p;
+}
+
+// saturates at UINT64_MAX, so huge ids stay out of range instead of wrapping
+inline const char* parseUint(const char* p, const char* end, uint64_t& value)
+{
+    constexpr uint64_t maxValue = std::numeric_limits<uint64_t>::max();
+    value = 0;
+    for (; p < end && isDigit(*p); ++p)
+        value = (value > (maxValue - 9) / 10) ? maxValue : value * 10 + (*p - '0');
+    return p;
+}
+
+// [-]digits[.digits][e[-]digits]
+inline const char* parseFloat(const char* p, const char* end, float& value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    double result = 0.0;
+    while (p < end && isDigit(*p))
+        result = result * 10.0 + (*p++ - '0');
+    if (p < end && *p == '.') {
+        double scale = 0.1;
+        for (++p; p < end && isDigit(*p); ++p, scale *= 0.1)
+            result += (*p - '0') * scale;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExp = *p++ == '-';
+        uint64_t exponent;
+        p = parseUint(p, end, exponent);
+        double scale = 1.0;
+        while (exponent--)
+            scale *= 10.0;
+        result = negativeExp ? result / scale : result * scale;
+    }
+    value = float(negative ? -result : result);
+    return p;
+}
+
+// fn(from, to, weight) for every edge line in [p, end), missing weight is 1.
+// Returns false if a line has a single number or a 0 id in one-based file, such lines are skipped.
+template <typename Fn>
+bool forEachEdge(const char* p, const char* end, bool oneBased, bool symmetric, Fn&& fn)
+{
+    bool valid = true;
+    while (p < end) {
+        p = skipBlanks(p, end);
+        if (p == end || !isDigit(*p)) { // comment, blank or broken line
+            p = skipLine(p, end);
+            continue;
+        }
+
+        uint64_t from, to;
+        p = parseUint(p, end, from);
+        p = skipBlanks(p, end);
+        if (p == end || !isDigit(*p)) {
+            valid = false;
+            p = skipLine(p, end);
+            continue;
+        }
+        p = parseUint(p, end, to);
+        p = skipBlanks(p, end);
+
+        float weight = 1.0f;
+        if (p < end && *p != '\n' && *p != '\r')
+            p = parseFloat(p, end, weight);
+        p = skipLine(p, end);
+
+        if (oneBased) {
+            if (from == 0 || to == 0) {
+                valid = false;
+                continue;
+            }
+            from--;
+            to--;
+        }
+        fn(from, to, weight);
+        if (symmetric && from != to)
+            fn(to, from, weight);
+    }
+    return valid;
+}
+
+} // namespace edge_list_parser
+
+// chunkEdges(chunkIndex, emit) calls emit(from, to, weight) for every edge of a chunk and returns
+// false on malformed input, it is called twice for every chunk. Returns false, with nothing allocated
+// in buf, if vertexNum alone does not fit buf, an id is >= vertexNum, a chunk is malformed,
+// edge number does not fit Edge or the graph does not fit buf.
+template <typename Graph, typename BufferType, typename ChunkEdges>
+bool buildCsrGraphParallel(ThreadPool& pool, BufferType& buf, size_t& graphOffset, typename Graph::Vertex vertexNum,
+    int chunkNum, ChunkEdges&& chunkEdges, bool weighted, bool transposed = false, bool sortNeighbors = true)
+{
+    using Vertex = typename Graph::Vertex;
+    using Edge = typename Graph::Edge;
+    using Weight = typename Graph::Weight;
+
+    if (!csrGraphFits<Graph>(buf, vertexNum, 0, weighted)) // before counters, they are as large as offsets
+        return false;
+
+    std::unique_ptr<std::atomic<Edge>[]> counters(new std::atomic<Edge>[(size_t)vertexNum + 1]);
+    pool.parallelForRange(size_t(0), (size_t)vertexNum + 1, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            counters[v].store(0, std::memory_order_relaxed);
+    });
+
+    std::vector<uint64_t> chunkEdgeNums(chunkNum, 0);
+    std::atomic<bool> valid { true };
+    pool.parallelFor(chunkNum, [&](int chunkIndex) {
+        uint64_t edgeNum = 0;
+        bool idsValid = true;
+        const bool chunkValid = chunkEdges(chunkIndex, [&](uint64_t from, uint64_t to, float) {
+            if (from >= vertexNum || to >= vertexNum) {
+                idsValid = false;
+                return;
+            }
+            counters[(transposed ? to : from) + 1].fetch_add(1, std::memory_order_relaxed);
+            edgeNum++;
+        });
+        chunkEdgeNums[chunkIndex] = edgeNum;
+        if (!chunkValid || !idsValid)
+            valid.store(false, std::memory_order_relaxed);
+    });
+    if (!valid.load(std::memory_order_relaxed))
+        return false;
+
+    // counted in 64 bits, Edge may be 32 bits and would wrap
+    uint64_t edgeNum = 0;
+    for (uint64_t chunkEdgeNum : chunkEdgeNums)
+        edgeNum += chunkEdgeNum;
+    if (edgeNum > (uint64_t)std::numeric_limits<Edge>::max() || !csrGraphFits<Graph>(buf, vertexNum, edgeNum, weighted))
+        return false;
+
+    graphOffset = allocateCsrGraph<Graph>(buf, vertexNum, (Edge)edgeNum, weighted);
+    Graph* graph = getCsrGraph<Graph>(buf, graphOffset);
+    Edge* offsets = graph->getOffsets();
+    for (size_t v = 0; v <= vertexNum; ++v)
+        offsets[v] = counters[v].load(std::memory_order_relaxed);
+    csrDegreesToOffsets(graph);
+    for (size_t v = 0; v < vertexNum; ++v)
+        counters[v].store(offsets[v], std::memory_order_relaxed); // row cursors
+
+    Vertex* adjacency = graph->getAdjacency();
+    Weight* weights = graph->getWeights();
+    pool.parallelFor(chunkNum, [&](int chunkIndex) {
+        chunkEdges(chunkIndex, [&](uint64_t from, uint64_t to, float weight) {
+            assert(from < vertexNum && to < vertexNum); // checked by the counting pass
+            const Edge e = counters[transposed ? to : from].fetch_add(1, std::memory_order_relaxed);
+            adjacency[e] = transposed ? from : to;
+            if (weights)
+                weights[e] = (Weight)weight;
+        });
+    });
+
+    if (sortNeighbors)
+        pool.parallelForRange(size_t(0), (size_t)vertexNum, [&](size_t begin, size_t end) { sortCsrNeighbors(graph, begin, end); });
+    return true;
+}
+
+// vertexNum = 0: taken from the Matrix Market size line, otherwise max of SNAP "# Nodes:" and max id + 1.
+// Given or Matrix Market vertex number is exact, ids past it fail the load.
+template <typename Graph, typename BufferType>
+bool loadTextEdgeList(ThreadPool& pool, BufferType& buf, const char* path, size_t& graphOffset,
+    bool weighted = false, bool transposed = false, uint64_t vertexNum = 0)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+
+    const char* begin = (const char*)file.data();
+    const char* end = begin + file.size();
+    const char* body = begin;
+
+    // header: leading comment lines, Matrix Market size line
+    bool oneBased = false;
+    bool symmetric = false;
+    uint64_t headerVertexNum = 0; // SNAP, lower bound
+    const bool matrixMarket = file.size() >= 14 && memcmp(begin, "%%MatrixMarket", 14) == 0;
+    if (matrixMarket) {
+        const char* headerEnd = edge_list_parser::skipLine(begin, end);
+        symmetric = memmem(begin, headerEnd - begin, "symmetric", 9) != nullptr;
+        oneBased = true;
+    }
+    while (body < end && (*body == '#' || *body == '%')) {
+        const char* lineEnd = edge_list_parser::skipLine(body, end);
+        const char* nodes = (const char*)memmem(body, lineEnd - body, "Nodes:", 6); // SNAP
+        if (nodes)
+            edge_list_parser::parseUint(edge_list_parser::skipBlanks(nodes + 6, lineEnd), lineEnd, headerVertexNum);
+        body = lineEnd;
+    }
+    if (matrixMarket) {
+        uint64_t rows = 0, cols = 0;
+        const char* p = edge_list_parser::parseUint(edge_list_parser::skipBlanks(body, end), end, rows);
+        edge_list_parser::parseUint(edge_list_parser::skipBlanks(p, end), end, cols);
+        if (vertexNum == 0)
+            vertexNum = std::max(rows, cols);
+        body = edge_list_parser::skipLine(body, end);
+    }
+
+    // chunks start after a newline
+    const int chunkNum = std::max<int>(1, std::min<int64_t>(pool.getThreadNum() * 4, (end - body) / (1 << 16) + 1));
+    std::vector<const char*> chunkBegins(chunkNum + 1);
+    chunkBegins[0] = body;
+    chunkBegins[chunkNum] = end;
+    for (int i = 1; i < chunkNum; ++i) {
+        const char* p = body + (end - body) * i / chunkNum;
+        chunkBegins[i] = (p <= body) ? body : edge_list_parser::skipLine(p - 1, end); // p - 1: p may be a line start
+        chunkBegins[i] = std::max(chunkBegins[i], chunkBegins[i - 1]);
+    }
+
+    auto chunkEdges = [&](int chunkIndex, auto&& emit) {
+        return edge_list_parser::forEachEdge(chunkBegins[chunkIndex], chunkBegins[chunkIndex + 1], oneBased, symmetric, emit);
+    };
+
+    constexpr uint64_t maxVertexNum = std::numeric_limits<typename Graph::Vertex>::max();
+    if (vertexNum == 0) {
+        // vertex num = max id + 1, 0 if there are no edges
+        std::vector<uint64_t> chunkVertexNums(chunkNum, 0);
+        std::atomic<bool> valid { true };
+        pool.parallelFor(chunkNum, [&](int chunkIndex) {
+            uint64_t maxId = 0;
+            bool hasEdges = false;
+            if (!chunkEdges(chunkIndex, [&](uint64_t from, uint64_t to, float) {
+                    maxId = std::max(maxId, std::max(from, to));
+                    hasEdges = true;
+                }))
+                valid.store(false, std::memory_order_relaxed);
+            chunkVertexNums[chunkIndex] = !hasEdges ? 0 : std::min(maxId, maxVertexNum) + 1;
+        });
+        if (!valid.load(std::memory_order_relaxed))
+            return false;
+        vertexNum = headerVertexNum;
+        for (uint64_t chunkVertexNum : chunkVertexNums)
+            vertexNum = std::max(vertexNum, chunkVertexNum);
+        if (vertexNum == 0)
+            return false;
+    }
+
+    if (vertexNum > maxVertexNum)
+        return false;
+
+    return buildCsrGraphParallel<Graph>(pool, buf, graphOffset, vertexNum, chunkNum, chunkEdges, weighted, transposed);
+}
+
+template <typename Graph, typename BufferType>
+bool loadBinaryEdgeList(ThreadPool& pool, BufferType& buf, const char* path, size_t& graphOffset, bool transposed = false)
+{
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(EdgeListBinaryHeader))
+        return false;
+
+    EdgeListBinaryHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    const size_t recordSize = header.weighted ? 12 : 8;
+    if (header.magic != EdgeListBinaryHeader::currentMagic
+        || header.edgeNum > (file.size() - sizeof(header)) / recordSize // no overflow in edgeNum * recordSize
+        || header.vertexNum > (uint64_t)std::numeric_limits<typename Graph::Vertex>::max())
+        return false;
+
+    const uint8_t* records = file.data() + sizeof(header);
+    const int chunkNum = std::max<int>(1, std::min<uint64_t>(pool.getThreadNum() * 4, header.edgeNum / (1 << 14) + 1));
+
+    auto chunkEdges = [&](int chunkIndex, auto&& emit) {
+        const uint64_t begin = header.edgeNum * chunkIndex / chunkNum;
+        const uint64_t end = header.edgeNum * (chunkIndex + 1) / chunkNum;
+        for (uint64_t i = begin; i < end; ++i) {
+            uint32_t fromTo[2];
+            float weight = 1.0f;
+            memcpy(fromTo, records + i * recordSize, sizeof(fromTo));
+            if (header.weighted)
+                memcpy(&weight, records + i * recordSize + 8, sizeof(weight));
+            emit(fromTo[0], fromTo[1], weight);
+        }
+        return true;
+    };
+
+    return buildCsrGraphParallel<Graph>(pool, buf, graphOffset, header.vertexNum, chunkNum, chunkEdges, header.weighted, transposed);
+}
+
+// records are buffered and written in large blocks
+template <typename Graph>
+bool saveBinaryEdgeList(const char* path, const Graph* graph)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return false;
+
+    EdgeListBinaryHeader header {};
+    header.magic = EdgeListBinaryHeader::currentMagic;
+    header.weighted = graph->isWeighted();
+    header.vertexNum = graph->vertexNum;
+    header.edgeNum = graph->edgeNum;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    const size_t recordSize = header.weighted ? 12 : 8;
+    std::vector<uint8_t> block;
+    block.reserve(recordSize * (1 << 16));
+
+    for (size_t v = 0; v < graph->vertexNum && ok; ++v) {
+        graph->forEachNeighbor(v, [&](typename Graph::Vertex n, typename Graph::Weight w) {
+            const uint32_t fromTo[2] = { (uint32_t)v, (uint32_t)n };
+            const float weight = (float)w;
+            const size_t pos = block.size();
+            block.resize(pos + recordSize);
+            memcpy(block.data() + pos, fromTo, sizeof(fromTo));
+            if (header.weighted)
+                memcpy(block.data() + pos + 8, &weight, sizeof(weight));
+        });
+        if (block.size() >= recordSize * (1 << 16)) {
+            ok = fwrite(block.data(), 1, block.size(), f) == block.size();
+            block.clear();
+        }
+    }
+    if (ok && !block.empty())
+        ok = fwrite(block.data(), 1, block.size(), f) == block.size();
+    return (fclose(f) == 0) && ok;
+}
+
+#endif // EDGE_LIST_LOADER_H
@@ -0,0 +1,272 @@
+#ifndef SHORTEST_PATHS_H
+#define SHORTEST_PATHS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+#include "csr_graph.h"
+
+/* Single source shortest paths, non-negative weights
+ *
+ * DIJKSTRA + RADIX HEAP
+ * Popped keys never decrease, so the heap only needs buckets by highest bit that differs
+ * from the last popped key. Push is O(1), each item is redistributed at most once per bit,
+ * buckets are plain vectors, no pointer chasing.
+ * Float weights are ordered by their bits (valid for non-negative floats).
+ *
+ * DELTA-STEPPING (Meyer, Sanders)
+ * Vertices are kept in buckets of width delta, all vertices of the smallest bucket are relaxed
+ * in parallel with atomic min on distances, the bucket is repeated until it stays empty.
+ * Small delta -> close to Dijkstra, less wasted work. Large delta -> more parallelism, more re-relaxations.
+ * Every task has own bins, no shared queue. Relaxation from bin b lands at most maxWeight / delta bins
+ * ahead, so bins are a ring of that size, delta is raised if the ring would be larger than maxBinNum.
+ * Distance and parent of a vertex are one 64-bit atomic, parent is written by the same CAS that
+ * lowers the distance, so parents form a tree also with zero weight edges.
+ *
+ * Both return ShortestPaths, unweighted graphs use weight 1.
+ *
+ * auto paths = dijkstraRadixHeap(graph, source);
+ * auto paths = deltaStepping(pool, graph, source, delta);
+ */
+
+template <typename VertexT, typename WeightT>
+struct ShortestPaths {
+    static constexpr VertexT noParent = std::numeric_limits<VertexT>::max();
+    static constexpr WeightT unreachable = std::numeric_limits<WeightT>::has_infinity
+        ? std::numeric_limits<WeightT>::infinity()
+        : std::numeric_limits<WeightT>::max();
+
+    std::vector<WeightT> distances; // unreachable if not reached
+    std::vector<VertexT> parents; // noParent if not reached, source is its own parent
+};
+
+// order preserving unsigned key of a non-negative weight
+template <typename WeightT>
+auto radixKey(WeightT weight)
+{
+    if constexpr (std::is_same_v<WeightT, float>) {
+        uint32_t key;
+        memcpy(&key, &weight, sizeof(key));
+        return key;
+    } else if constexpr (std::is_same_v<WeightT, double>) {
+        uint64_t key;
+        memcpy(&key, &weight, sizeof(key));
+        return key;
+    } else {
+        static_assert(std::is_integral_v<WeightT>);
+        return std::make_unsigned_t<WeightT>(weight);
+    }
+}
+
+// monotone priority queue: pushed keys must be >= last popped key
+template <typename KeyT, typename ValueT>
+class RadixHeap {
+    static_assert(std::is_unsigned_v<KeyT>);
+    static constexpr int bucketNum = sizeof(KeyT) * 8 + 1;
+
+    std::vector<std::pair<KeyT, ValueT>> m_buckets[bucketNum];
+    KeyT m_last {};
+    size_t m_size {};
+
+    static int bucketIndex(KeyT key, KeyT last)
+    {
+        const KeyT diff = key ^ last;
+        return diff ? (int)(sizeof(unsigned long long) * 8 - __builtin_clzll((unsigned long long)diff)) : 0;
+    }
+
+public:
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    void push(KeyT key, const ValueT& value)
+    {
+        assert(key >= m_last);
+        m_buckets[bucketIndex(key, m_last)].push_back({ key, value });
+        m_size++;
+    }
+
+    std::pair<KeyT, ValueT> pop()
+    {
+        assert(m_size > 0);
+        if (m_buckets[0].empty()) {
+            int i = 1;
+            while (m_buckets[i].empty())
+                i++;
+
+            // every item of bucket i goes to a lower bucket relative to new minimum
+            auto& bucket = m_buckets[i];
+            m_last = std::min_element(bucket.begin(), bucket.end())->first;
+            for (const auto& item : bucket)
+                m_buckets[bucketIndex(item.first, m_last)].push_back(item);
+            bucket.clear();
+        }
+
+        auto item = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        m_size--;
+        return item;
+    }
+};
+
+template <typename Graph>
+ShortestPaths<typename Graph::Vertex, typename Graph::Weight> dijkstraRadixHeap(const Graph* graph, typename Graph::Vertex source)
+{
+    using Vertex = typename Graph::Vertex;
+    using Weight = typename Graph::Weight;
+    using Result = ShortestPaths<Vertex, Weight>;
+
+    Result result;
+    result.distances.assign(graph->vertexNum, Result::unreachable);
+    result.parents.assign(graph->vertexNum, Result::noParent);
+    result.distances[source] = 0;
+    result.parents[source] = source;
+
+    RadixHeap<decltype(radixKey(Weight {})), Vertex> heap;
+    heap.push(radixKey(Weight(0)), source);
+
+    while (!heap.empty()) {
+        const auto [key, u] = heap.pop();
+        if (key != radixKey(result.distances[u])) // stale, u was reached shorter
+            continue;
+
+        const Weight distU = result.distances[u];
+        graph->forEachNeighbor(u, [&](Vertex v, Weight w) {
+            assert(w >= 0);
+            const Weight distV = distU + w;
+            if (distV < result.distances[v]) {
+                result.distances[v] = distV;
+                result.parents[v] = u;
+                heap.push(radixKey(distV), v);
+            }
+        });
+    }
+    return result;
+}
+
+template <typename Graph>
+ShortestPaths<typename Graph::Vertex, typename Graph::Weight> deltaStepping(ThreadPool& pool,
+    const Graph* graph, typename Graph::Vertex source, typename Graph::Weight delta)
+{
+    using Vertex = typename Graph::Vertex;
+    using Weight = typename Graph::Weight;
+    using Result = ShortestPaths<Vertex, Weight>;
+    static constexpr size_t noBin = std::numeric_limits<size_t>::max();
+    static constexpr size_t maxBin = noBin / 2;
+    static constexpr size_t maxBinNum = 1 << 14;
+
+    struct DistanceParent {
+        Weight distance;
+        Vertex parent;
+    };
+    static_assert(sizeof(DistanceParent) <= 8, "distance and parent must fit one lock-free CAS");
+
+    assert(delta > 0);
+    const size_t vertexNum = graph->vertexNum;
+
+    std::unique_ptr<std::atomic<DistanceParent>[]> states(new std::atomic<DistanceParent>[vertexNum]);
+    pool.parallelForRange(size_t(0), vertexNum, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v)
+            states[v].store({ Result::unreachable, Result::noParent }, std::memory_order_relaxed);
+    });
+    states[source].store({ Weight(0), source }, std::memory_order_relaxed);
+
+    const int taskNum = pool.getThreadNum();
+    Weight maxWeight = Weight(1);
+    if (const Weight* weights = graph->getWeights()) {
+        std::vector<Weight> taskMaxWeights(taskNum, Weight(0));
+        pool.parallelFor(taskNum, [&](int taskIndex) {
+            const size_t begin = (size_t)graph->edgeNum * taskIndex / taskNum;
+            const size_t end = (size_t)graph->edgeNum * (taskIndex + 1) / taskNum;
+            for (size_t e = begin; e < end; ++e)
+                taskMaxWeights[taskIndex] = std::max(taskMaxWeights[taskIndex], weights[e]);
+        });
+        maxWeight = *std::max_element(taskMaxWeights.begin(), taskMaxWeights.end());
+    }
+
+    // bin of distU + w is in [bin of distU, + maxWeight / delta + 1], one more for float rounding
+    if (maxWeight / delta > Weight(maxBinNum - 3)) {
+        if constexpr (std::is_floating_point_v<Weight>)
+            delta = maxWeight / Weight(maxBinNum - 3);
+        else
+            delta = (maxWeight + Weight(maxBinNum - 4)) / Weight(maxBinNum - 3);
+    }
+    const size_t binNum = (size_t)(maxWeight / delta) + 3;
+
+    // clamped, huge float distance / delta does not fit size_t
+    auto binOf = [&](Weight distance) {
+        if constexpr (std::is_floating_point_v<Weight>)
+            if (!(distance / delta < Weight(maxBin)))
+                return maxBin;
+        return std::min((size_t)(distance / delta), maxBin);
+    };
+
+    std::vector<std::vector<std::vector<Vertex>>> taskBins(taskNum, std::vector<std::vector<Vertex>>(binNum)); // [task][bin % binNum]
+    std::vector<Vertex> frontier { source };
+
+    for (size_t currentBin = 0; currentBin != noBin;) {
+        pool.parallelFor(taskNum, [&](int taskIndex) {
+            auto& bins = taskBins[taskIndex];
+            const size_t begin = frontier.size() * taskIndex / taskNum;
+            const size_t end = frontier.size() * (taskIndex + 1) / taskNum;
+
+            for (size_t i = begin; i < end; ++i) {
+                const Vertex u = frontier[i];
+                const Weight distU = states[u].load(std::memory_order_relaxed).distance;
+                if (binOf(distU) < currentBin) // settled in an earlier bin, duplicate entry
+                    continue;
+
+                graph->forEachNeighbor(u, [&](Vertex v, Weight w) {
+                    const DistanceParent newState { distU + w, u };
+                    DistanceParent oldState = states[v].load(std::memory_order_relaxed);
+                    while (newState.distance < oldState.distance) {
+                        if (states[v].compare_exchange_weak(oldState, newState, std::memory_order_relaxed)) {
+                            const size_t bin = binOf(newState.distance);
+                            assert(bin >= currentBin && bin - currentBin < binNum);
+                            bins[bin % binNum].push_back(v);
+                            break;
+                        }
+                    }
+                });
+            }
+        });
+
+        // smallest non-empty bin of all tasks, current bin again if it got new vertices
+        size_t nextBin = noBin;
+        for (const auto& bins : taskBins)
+            for (size_t bin = currentBin; bin < std::min(currentBin + binNum, nextBin); ++bin)
+                if (!bins[bin % binNum].empty()) {
+                    nextBin = bin;
+                    break;
+                }
+
+        frontier.clear();
+        if (nextBin != noBin) {
+            for (auto& bins : taskBins) {
+                auto& bin = bins[nextBin % binNum];
+                frontier.insert(frontier.end(), bin.begin(), bin.end());
+                bin.clear();
+            }
+        }
+        currentBin = nextBin;
+    }
+
+    Result result;
+    result.distances.resize(vertexNum);
+    result.parents.resize(vertexNum);
+    for (size_t v = 0; v < vertexNum; ++v) {
+        const DistanceParent state = states[v].load(std::memory_order_relaxed);
+        result.distances[v] = state.distance;
+        result.parents[v] = state.parent;
+    }
+    return result;
+}
+
+#endif // SHORTEST_PATHS_H
@@ -0,0 +1,168 @@
+#ifndef SUCCINCT_TREE_H
+#define SUCCINCT_TREE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../containers/arena_buffer.h"
+#include "../containers/rank_select_bitvector.h"
+#include "dense_tree.h"
+
+/* Succinct binary tree (LOUDS for binary trees)
+ *
+ * Topology is 2 bits per node in level order: bit 2v = v has left child, bit 2v + 1 = v has right child.
+ * Node ids are level order positions, root is 0, the k-th set bit (from 1) is node k, so
+ *   left(v) = rank1(2v + 1), right(v) = rank1(2v + 2), parent(v) = select1(v) / 2.
+ * Descendants of v on every level are a contiguous id range, subtreeSize walks these ranges, O(depth).
+ *
+ * Payloads are a separate array in level order: DataType[nodeNum], or for char (strings)
+ * a blob of null terminated strings with a start bit per byte, string v starts at select1(v + 1).
+ * Everything is in one ArenaBuffer, relative to the SuccinctTree header.
+ *
+ * size_t treeOffset = buildSuccinctTree<BufferType, SrcBufferType, Node_t, RelPtrType>(buf, srcBuf, root);
+ * const auto* tree = getSuccinctTree<char>(buf, treeOffset);
+ * tree->getData(tree->left(0));
+ */
+
+template <typename DataType>
+struct SuccinctTree {
+    static constexpr uint64_t noNode = UINT64_MAX;
+    static constexpr bool isString = std::is_same_v<DataType, char>;
+
+    uint64_t nodeNum;
+    uint64_t topologyRel;
+    uint64_t payloadsRel;
+    uint64_t payloadStartsRel; // strings only
+    uint64_t payloadBytes;
+
+    const RankSelectBitVector* getTopology() const { return (const RankSelectBitVector*)((const uint8_t*)this + topologyRel); }
+    const RankSelectBitVector* getPayloadStarts() const { return (const RankSelectBitVector*)((const uint8_t*)this + payloadStartsRel); }
+
+    bool hasLeft(uint64_t v) const { return getTopology()->get(2 * v); }
+    bool hasRight(uint64_t v) const { return getTopology()->get(2 * v + 1); }
+    bool isLeaf(uint64_t v) const { return !hasLeft(v) && !hasRight(v); }
+
+    uint64_t left(uint64_t v) const { return hasLeft(v) ? getTopology()->rank1(2 * v + 1) : noNode; }
+    uint64_t right(uint64_t v) const { return hasRight(v) ? getTopology()->rank1(2 * v + 2) : noNode; }
+    uint64_t parent(uint64_t v) const { return v == 0 ? noNode : getTopology()->select1(v) / 2; }
+    bool isLeftChild(uint64_t v) const { return v != 0 && getTopology()->select1(v) % 2 == 0; }
+
+    uint64_t sibling(uint64_t v) const
+    {
+        if (v == 0)
+            return noNode;
+        const size_t position = getTopology()->select1(v);
+        if (position % 2 == 0) // left child, right sibling is the next set bit
+            return getTopology()->get(position + 1) ? v + 1 : noNode;
+        return getTopology()->get(position - 1) ? v - 1 : noNode;
+    }
+
+    uint64_t subtreeSize(uint64_t v) const
+    {
+        const RankSelectBitVector* topology = getTopology();
+        uint64_t size = 0;
+        for (uint64_t first = v, last = v; first <= last;) {
+            size += last - first + 1;
+            // children of [first, last] are set bits in [2 first, 2 last + 1]
+            const uint64_t before = topology->rank1(2 * first);
+            const uint64_t through = topology->rank1(2 * last + 2);
+            first = before + 1;
+            last = through;
+        }
+        return size;
+    }
+
+    const DataType* getData(uint64_t v) const
+    {
+        const DataType* payloads = (const DataType*)((const uint8_t*)this + payloadsRel);
+        if constexpr (isString)
+            return payloads + getPayloadStarts()->select1(v + 1);
+        else
+            return payloads + v;
+    }
+};
+
+template <typename DataType, typename BufferType>
+const SuccinctTree<DataType>* getSuccinctTree(const BufferType& buf, size_t treeOffset) { return (const SuccinctTree<DataType>*)(buf.data + treeOffset); }
+
+// level order copy of a DenseTreeNode tree
+template <typename BufferType, typename SrcBufferType, typename Node_t, typename RelPtrType>
+size_t buildSuccinctTree(BufferType& buf, SrcBufferType& srcBuf, RelPtrType rootOffset)
+{
+    using DataType = std::remove_pointer_t<decltype(std::declval<Node_t&>().getData())>;
+    using Tree = SuccinctTree<DataType>;
+
+    std::vector<RelPtrType> levelOrder;
+    if (rootOffset != (RelPtrType)-1)
+        levelOrder.push_back(rootOffset);
+    uint64_t payloadBytes = 0;
+    for (size_t head = 0; head < levelOrder.size(); ++head) { // levelOrder is the queue
+        Node_t* node = (Node_t*)(srcBuf.data + levelOrder[head]);
+        payloadBytes += Tree::isString ? strlen((const char*)node->getData()) + 1 : sizeof(DataType);
+        if (node->l != (RelPtrType)-1)
+            levelOrder.push_back(node->l);
+        if (node->r != (RelPtrType)-1)
+            levelOrder.push_back(node->r);
+    }
+    const uint64_t nodeNum = levelOrder.size();
+
+    const size_t treeOffset = buf.template allocate<Tree>(1);
+    const size_t topologyOffset = allocateBitVector(buf, 2 * nodeNum);
+    for (uint64_t v = 0; v < nodeNum; ++v) {
+        Node_t* node = (Node_t*)(srcBuf.data + levelOrder[v]);
+        if (node->l != (RelPtrType)-1)
+            getBitVector(buf, topologyOffset)->set(2 * v);
+        if (node->r != (RelPtrType)-1)
+            getBitVector(buf, topologyOffset)->set(2 * v + 1);
+    }
+    buildRankSelectIndex(buf, topologyOffset);
+
+    const size_t payloadsOffset = buf.template allocate<DataType>(Tree::isString ? payloadBytes : nodeNum);
+    size_t startsOffset = 0;
+    if constexpr (Tree::isString) {
+        startsOffset = allocateBitVector(buf, payloadBytes);
+        char* blob = (char*)(buf.data + payloadsOffset);
+        size_t position = 0;
+        for (uint64_t v = 0; v < nodeNum; ++v) {
+            const char* str = (const char*)((Node_t*)(srcBuf.data + levelOrder[v]))->getData();
+            getBitVector(buf, startsOffset)->set(position);
+            strcpy(blob + position, str);
+            position += strlen(str) + 1;
+        }
+        buildRankSelectIndex(buf, startsOffset);
+    } else {
+        DataType* payloads = (DataType*)(buf.data + payloadsOffset);
+        for (uint64_t v = 0; v < nodeNum; ++v)
+            payloads[v] = *((Node_t*)(srcBuf.data + levelOrder[v]))->getData();
+    }
+
+    Tree* tree = (Tree*)(buf.data + treeOffset);
+    tree->nodeNum = nodeNum;
+    tree->topologyRel = topologyOffset - treeOffset;
+    tree->payloadsRel = payloadsOffset - treeOffset;
+    tree->payloadStartsRel = Tree::isString ? startsOffset - treeOffset : 0;
+    tree->payloadBytes = Tree::isString ? payloadBytes : nodeNum * sizeof(DataType);
+    return treeOffset;
+}
+
+template <typename DataType>
+void printSuccinctTree(const SuccinctTree<DataType>* tree, uint64_t v, int level, size_t childBitfield)
+{
+    if (v == SuccinctTree<DataType>::noNode || tree->nodeNum == 0)
+        return;
+
+    printTreePrefix(level, childBitfield);
+    printPayload(tree->getData(v));
+
+    childBitfield <<= 1;
+    printSuccinctTree(tree, tree->left(v), level + 1, childBitfield);
+    childBitfield |= 1;
+    printSuccinctTree(tree, tree->right(v), level + 1, childBitfield);
+}
+
+#endif // SUCCINCT_TREE_H
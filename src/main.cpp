@@ -8,6 +8,7 @@
 
 #include "3party/fruits.h"
 #include "graph/dense_tree.h"
+#include "graph/succinct_tree.h"
 
 #define ARR_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
@@ -27,6 +28,47 @@ int main()
 #endif
 
     printf("Tree size: %zu\n", buf.size);
+
+    // 2 bits per node topology, fixed headers dominate for small trees
+    ArenaBuffer<2048> succinctBuf;
+    auto succinctOffset = buildSuccinctTree<typeof(succinctBuf), typeof(buf), Node_t, RelativePointerType>(succinctBuf, buf, root);
+    const auto* succinctTree = getSuccinctTree<char>(succinctBuf, succinctOffset);
+    printf("Succinct tree size: %zu, topology %llu bits, payloads %llu bytes, subtree of root: %llu\n", succinctBuf.size,
+        (unsigned long long)succinctTree->getTopology()->bitNum, (unsigned long long)succinctTree->payloadBytes,
+        (unsigned long long)succinctTree->subtreeSize(0));
+
+    // same tree, left child is implicit
+    srand(1);
+    ArenaBuffer<2048> implicitBuf;
+    using ImplicitNode_t = ImplicitDenseTreeNode<char, RelativePointerType>;
+    auto implicitRoot = makeRandomImplicitTree<typeof(implicitBuf), ImplicitNode_t, RelativePointerType>(implicitBuf, 4, (char**)fruits, ARR_SIZE(fruits));
+    printImplicitTree((ImplicitNode_t*)(implicitBuf.data + implicitRoot), 0, 0);
+    printf("Implicit tree size: %zu\n", implicitBuf.size);
+
+    // numeric payload, header is half of the node, same tree with DenseTreeNode for comparison
+    ArenaBuffer<2048> numericBuf, numericDenseBuf;
+    auto writeNumber = [](auto& b) { *(uint16_t*)(b.data + b.template allocate<uint16_t>(1)) = rand() % 1000; };
+    srand(3);
+    makeImplicitTree<typeof(numericBuf), ImplicitDenseTreeNode<uint16_t, uint16_t>, uint16_t>(numericBuf, 4, writeNumber);
+    srand(3);
+    makeTree<typeof(numericDenseBuf), DenseTreeNode<uint16_t, uint16_t>, uint16_t>(numericDenseBuf, 4, writeNumber);
+    printf("Numeric implicit tree size: %zu (DenseTreeNode: %zu)\n", numericBuf.size, numericDenseBuf.size);
+
+    // repeated strings are stored once, 255 nodes from the fruits table
+    ArenaBuffer<8192> largeBuf, internedBuf;
+    srand(2);
+    makeRandomTree<typeof(largeBuf), DenseTreeNode<char, uint16_t>, uint16_t>(largeBuf, 8, (char**)fruits, ARR_SIZE(fruits));
+    srand(2);
+    PayloadInterner<uint16_t> interner;
+    makeRandomInternedTree<typeof(internedBuf), InternedDenseTreeNode<char, uint16_t>, uint16_t>(internedBuf, 8, (char**)fruits, ARR_SIZE(fruits), interner);
+    printf("Large tree size: %zu, interned: %zu (%zu unique strings)\n", largeBuf.size, internedBuf.size, interner.getUniqueNum());
+
+    // length-prefixed payloads, short strings inline, long ones interned
+    ArenaBuffer<8192> sizedBuf;
+    srand(2);
+    PayloadInterner<uint16_t> sizedInterner;
+    makeRandomSizedTree<typeof(sizedBuf), SizedDenseTreeNode<uint16_t>, uint16_t>(sizedBuf, 8, (char**)fruits, ARR_SIZE(fruits), sizedInterner);
+    printf("Length-prefixed tree size: %zu\n", sizedBuf.size);
 }
 
 // uncategorized drafts
@@ -0,0 +1,394 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "../containers/arena_buffer.h"
+#include "geometry.h"
+
+/* Bounding Volume Hierarchy over triangles
+ *
+ * Same idea as DenseTreeNode: nodes are in one ArenaBuffer in depth-first order,
+ * LEFT child is IMPLICIT (next node), right child is a RELATIVE offset (in nodes) from the parent.
+ * Bvh header, nodes, triangles (reordered to leaf order) and original triangle indices
+ * are addressed relative to the Bvh header, so the whole BVH is relocatable.
+ *
+ * BvhNode is 32 bytes, 2 nodes per cache line, the top levels of a million triangle BVH
+ * (first few thousand nodes) stay in L1/L2, subtree is contiguous in memory.
+ *
+ * Build: binned SAH, 16 bins per axis, O(N log N), deep subtrees fall back to median split.
+ * Traversal: near child first, far child goes to a short stack of node indices.
+ *
+ * size_t bvhOffset = buildBvhSah(buf, triangles, triangleNum);
+ * const Bvh* bvh = getBvh(buf, bvhOffset);
+ * BvhHit hit;
+ * if (intersectBvh(bvh, ray, hit)) ... hit.triangle, hit.t
+ */
+
+struct BvhNode {
+    float boundsMin[3];
+    uint32_t rightOrFirst; // inner: offset to right child in nodes, leaf: first triangle
+    float boundsMax[3];
+    uint32_t triangleNum; // 0 for inner node
+
+    bool isLeaf() const { return triangleNum != 0; }
+    const BvhNode* getLeft() const { return this + 1; }
+    const BvhNode* getRight() const { return this + rightOrFirst; }
+    Vec3 getMin() const { return { boundsMin[0], boundsMin[1], boundsMin[2] }; }
+    Vec3 getMax() const { return { boundsMax[0], boundsMax[1], boundsMax[2] }; }
+
+    void setBounds(const Aabb& b)
+    {
+        boundsMin[0] = b.min.x, boundsMin[1] = b.min.y, boundsMin[2] = b.min.z;
+        boundsMax[0] = b.max.x, boundsMax[1] = b.max.y, boundsMax[2] = b.max.z;
+    }
+};
+static_assert(sizeof(BvhNode) == 32);
+
+struct Bvh {
+    uint32_t nodeNum;
+    uint32_t triangleNum;
+    uint64_t nodesRel;
+    uint64_t trianglesRel;
+    uint64_t triangleIndicesRel;
+
+    const BvhNode* getNodes() const { return (const BvhNode*)((const uint8_t*)this + nodesRel); }
+    const Triangle* getTriangles() const { return (const Triangle*)((const uint8_t*)this + trianglesRel); }
+    const uint32_t* getTriangleIndices() const { return (const uint32_t*)((const uint8_t*)this + triangleIndicesRel); }
+    BvhNode* getNodes() { return (BvhNode*)((uint8_t*)this + nodesRel); }
+    Triangle* getTriangles() { return (Triangle*)((uint8_t*)this + trianglesRel); }
+    uint32_t* getTriangleIndices() { return (uint32_t*)((uint8_t*)this + triangleIndicesRel); }
+};
+
+struct BvhHit {
+    float t = std::numeric_limits<float>::infinity();
+    float u {}, v {};
+    uint32_t triangle = UINT32_MAX; // index in the original triangle array
+};
+
+template <typename BufferType>
+const Bvh* getBvh(const BufferType& buf, size_t bvhOffset) { return (const Bvh*)(buf.data + bvhOffset); }
+
+// header, nodeNum nodes and triangleNum triangles with indices, all in buf
+template <typename BufferType>
+size_t allocateBvh(BufferType& buf, uint32_t nodeNum, uint32_t triangleNum)
+{
+    const size_t bvhOffset = buf.template allocate<Bvh>(1);
+    const size_t nodesOffset = buf.template allocate<BvhNode>(nodeNum);
+    const size_t trianglesOffset = buf.template allocate<Triangle>(triangleNum);
+    const size_t indicesOffset = buf.template allocate<uint32_t>(triangleNum);
+
+    Bvh* bvh = (Bvh*)(buf.data + bvhOffset);
+    bvh->nodeNum = nodeNum;
+    bvh->triangleNum = triangleNum;
+    bvh->nodesRel = nodesOffset - bvhOffset;
+    bvh->trianglesRel = trianglesOffset - bvhOffset;
+    bvh->triangleIndicesRel = indicesOffset - bvhOffset;
+    return bvhOffset;
+}
+
+namespace bvh_sah {
+
+constexpr int binNum = 16;
+constexpr int maxLeafSize = 16; // SAH may stop earlier
+constexpr float traversalCost = 1.0f; // relative to one triangle test
+constexpr uint32_t medianSplitDepth = 24; // below it split by count, keeps depth under the traversal stack size
+
+struct PrimRef {
+    Aabb bounds;
+    Vec3 centroid;
+    uint32_t index;
+};
+
+struct Builder {
+    std::vector<PrimRef> refs;
+    std::vector<BvhNode> nodes;
+
+    struct Split {
+        int axis = -1;
+        int bin = 0;
+        float cost = std::numeric_limits<float>::max();
+    };
+
+    Split findSplit(uint32_t begin, uint32_t end, const Aabb& centroidBounds) const
+    {
+        Split best;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float lo = centroidBounds.min[axis];
+            const float extent = centroidBounds.max[axis] - lo;
+            if (extent <= 0.0f)
+                continue;
+
+            Aabb binBounds[binNum];
+            uint32_t binCounts[binNum] {};
+            const float scale = binNum / extent;
+            for (uint32_t i = begin; i < end; ++i) {
+                const int b = std::min(binNum - 1, (int)((refs[i].centroid[axis] - lo) * scale));
+                binBounds[b].grow(refs[i].bounds);
+                ++binCounts[b];
+            }
+
+            // sweep from the right, then from the left
+            float rightArea[binNum];
+            uint32_t rightCount[binNum];
+            Aabb acc;
+            uint32_t count = 0;
+            for (int b = binNum - 1; b > 0; --b) {
+                acc.grow(binBounds[b]);
+                count += binCounts[b];
+                rightArea[b] = acc.surfaceArea();
+                rightCount[b] = count;
+            }
+
+            acc = Aabb();
+            count = 0;
+            for (int b = 0; b < binNum - 1; ++b) {
+                acc.grow(binBounds[b]);
+                count += binCounts[b];
+                const float cost = acc.surfaceArea() * count + rightArea[b + 1] * rightCount[b + 1];
+                if (count && rightCount[b + 1] && cost < best.cost)
+                    best = { axis, b + 1, cost };
+            }
+        }
+        return best;
+    }
+
+    void makeLeaf(uint32_t nodeIndex, uint32_t begin, uint32_t end)
+    {
+        nodes[nodeIndex].rightOrFirst = begin;
+        nodes[nodeIndex].triangleNum = end - begin;
+    }
+
+    // emits nodes depth-first, left subtree right after its parent
+    void build(uint32_t begin, uint32_t end, uint32_t depth)
+    {
+        const uint32_t nodeIndex = nodes.size();
+        nodes.emplace_back();
+
+        Aabb bounds, centroidBounds;
+        for (uint32_t i = begin; i < end; ++i) {
+            bounds.grow(refs[i].bounds);
+            centroidBounds.grow(refs[i].centroid);
+        }
+        nodes[nodeIndex].setBounds(bounds);
+
+        const uint32_t count = end - begin;
+        if (count <= 2) {
+            makeLeaf(nodeIndex, begin, end);
+            return;
+        }
+
+        const Split split = depth < medianSplitDepth ? findSplit(begin, end, centroidBounds) : Split();
+        uint32_t mid;
+        if (split.axis < 0) { // all centroids in one point, split by count
+            if (count <= maxLeafSize) {
+                makeLeaf(nodeIndex, begin, end);
+                return;
+            }
+            mid = begin + count / 2;
+            const int axis = centroidBounds.longestAxis();
+            std::nth_element(refs.begin() + begin, refs.begin() + mid, refs.begin() + end,
+                [axis](const PrimRef& a, const PrimRef& b) { return a.centroid[axis] < b.centroid[axis]; });
+        } else {
+            const float leafCost = bounds.surfaceArea() * count;
+            const float splitCost = bounds.surfaceArea() * traversalCost + split.cost;
+            if (count <= maxLeafSize && leafCost <= splitCost) {
+                makeLeaf(nodeIndex, begin, end);
+                return;
+            }
+
+            const int axis = split.axis;
+            const float lo = centroidBounds.min[axis];
+            const float scale = binNum / (centroidBounds.max[axis] - lo);
+            mid = std::partition(refs.begin() + begin, refs.begin() + end, [&](const PrimRef& r) {
+                return std::min(binNum - 1, (int)((r.centroid[axis] - lo) * scale)) < split.bin;
+            }) - refs.begin();
+        }
+
+        build(begin, mid, depth + 1);
+        nodes[nodeIndex].rightOrFirst = nodes.size() - nodeIndex;
+        nodes[nodeIndex].triangleNum = 0;
+        build(mid, end, depth + 1);
+    }
+};
+
+} // namespace bvh_sah
+
+template <typename BufferType>
+size_t buildBvhSah(BufferType& buf, const Triangle* triangles, uint32_t triangleNum)
+{
+    bvh_sah::Builder builder;
+    builder.refs.resize(triangleNum);
+    for (uint32_t i = 0; i < triangleNum; ++i) {
+        const Aabb b = triangles[i].bounds();
+        builder.refs[i] = { b, b.center(), i };
+    }
+
+    builder.nodes.reserve(triangleNum ? 2 * triangleNum - 1 : 1);
+    if (triangleNum)
+        builder.build(0, triangleNum, 0);
+    else // empty root, traversal checks triangleNum
+        builder.nodes.emplace_back().setBounds(Aabb());
+
+    const size_t bvhOffset = allocateBvh(buf, builder.nodes.size(), triangleNum);
+    Bvh* bvh = (Bvh*)(buf.data + bvhOffset);
+    memcpy(bvh->getNodes(), builder.nodes.data(), builder.nodes.size() * sizeof(BvhNode));
+    for (uint32_t i = 0; i < triangleNum; ++i) {
+        bvh->getTriangles()[i] = triangles[builder.refs[i].index];
+        bvh->getTriangleIndices()[i] = builder.refs[i].index;
+    }
+    return bvhOffset;
+}
+
+// recompute node bounds from triangles, for deformed geometry with the same topology
+// children follow their parent, so a reverse pass is bottom-up
+inline void refitBvh(Bvh* bvh)
+{
+    if (bvh->triangleNum == 0)
+        return;
+
+    BvhNode* nodes = bvh->getNodes();
+    const Triangle* triangles = bvh->getTriangles();
+    for (int64_t i = (int64_t)bvh->nodeNum - 1; i >= 0; --i) {
+        BvhNode& node = nodes[i];
+        Aabb b;
+        if (node.isLeaf()) {
+            for (uint32_t t = node.rightOrFirst; t < node.rightOrFirst + node.triangleNum; ++t)
+                b.grow(triangles[t].bounds());
+        } else {
+            const BvhNode* l = node.getLeft();
+            const BvhNode* r = node.getRight();
+            b.min = min(l->getMin(), r->getMin());
+            b.max = max(l->getMax(), r->getMax());
+        }
+        node.setBounds(b);
+    }
+}
+
+constexpr int bvhStackSize = 128; // LBVH depth is bounded by code bits + index bits
+
+// closest hit, returns true if ray.tMax range has a hit
+// AnyHit = true stops at the first hit (shadow rays)
+template <bool AnyHit = false>
+bool intersectBvh(const Bvh* bvh, const Ray& ray, BvhHit& hit)
+{
+    if (bvh->triangleNum == 0)
+        return false;
+
+    const BvhNode* nodes = bvh->getNodes();
+    const Triangle* triangles = bvh->getTriangles();
+    const Vec3 invDir = safeInverse(ray.dir);
+
+    Ray r = ray;
+    bool found = false;
+
+    if (intersectAabb(nodes[0].getMin(), nodes[0].getMax(), r.origin, invDir, r.tMin, r.tMax) == std::numeric_limits<float>::infinity())
+        return false;
+
+    // far children with their entry distance, depth is limited by the builder
+    struct Entry {
+        uint32_t node;
+        float t;
+    } stack[bvhStackSize];
+    int stackSize = 0;
+    uint32_t current = 0;
+
+    while (true) {
+        const BvhNode& node = nodes[current];
+        if (node.isLeaf()) {
+            for (uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.triangleNum; ++i) {
+                float u, v;
+                const float t = intersectTriangle(triangles[i], r, u, v);
+                if (t < r.tMax) {
+                    r.tMax = t;
+                    hit.t = t, hit.u = u, hit.v = v;
+                    hit.triangle = i; // local, remapped below
+                    found = true;
+                    if constexpr (AnyHit)
+                        goto done;
+                }
+            }
+        } else {
+            const uint32_t left = current + 1;
+            const uint32_t right = current + node.rightOrFirst;
+            float tl = intersectAabb(nodes[left].getMin(), nodes[left].getMax(), r.origin, invDir, r.tMin, r.tMax);
+            float tr = intersectAabb(nodes[right].getMin(), nodes[right].getMax(), r.origin, invDir, r.tMin, r.tMax);
+            constexpr float miss = std::numeric_limits<float>::infinity();
+            if (tl != miss && tr != miss) {
+                const bool leftFirst = tl <= tr;
+                assert(stackSize < bvhStackSize);
+                stack[stackSize++] = leftFirst ? Entry { right, tr } : Entry { left, tl };
+                current = leftFirst ? left : right;
+                continue;
+            }
+            if (tl != miss) {
+                current = left;
+                continue;
+            }
+            if (tr != miss) {
+                current = right;
+                continue;
+            }
+        }
+
+        // pop, skip nodes that are behind the closest hit found since the push
+        do {
+            if (stackSize == 0)
+                goto done;
+            --stackSize;
+        } while (stack[stackSize].t > r.tMax);
+        current = stack[stackSize].node;
+    }
+
+done:
+    if (found)
+        hit.triangle = bvh->getTriangleIndices()[hit.triangle];
+    return found;
+}
+
+inline bool occludedBvh(const Bvh* bvh, const Ray& ray)
+{
+    BvhHit hit;
+    return intersectBvh<true>(bvh, ray, hit);
+}
+
+struct BvhStats {
+    uint32_t nodeNum {}, leafNum {}, maxDepth {}, maxLeafSize {};
+    float sahCost {}; // expected intersection cost relative to the root
+};
+
+inline BvhStats getBvhStats(const Bvh* bvh)
+{
+    BvhStats stats;
+    const BvhNode* nodes = bvh->getNodes();
+    stats.nodeNum = bvh->nodeNum;
+    if (bvh->triangleNum == 0)
+        return stats;
+
+    const float rootArea = std::max(Aabb { nodes[0].getMin(), nodes[0].getMax() }.surfaceArea(), 1e-20f);
+    std::vector<std::pair<uint32_t, uint32_t>> stack { { 0, 1 } };
+    while (!stack.empty()) {
+        const auto [index, depth] = stack.back();
+        stack.pop_back();
+        const BvhNode& node = nodes[index];
+        const float area = Aabb { node.getMin(), node.getMax() }.surfaceArea() / rootArea;
+        stats.maxDepth = std::max(stats.maxDepth, depth);
+        if (node.isLeaf()) {
+            ++stats.leafNum;
+            stats.maxLeafSize = std::max(stats.maxLeafSize, node.triangleNum);
+            stats.sahCost += area * node.triangleNum;
+        } else {
+            stats.sahCost += area * bvh_sah::traversalCost;
+            stack.push_back({ index + 1, depth + 1 });
+            stack.push_back({ index + node.rightOrFirst, depth + 1 });
+        }
+    }
+    return stats;
+}
+
+#endif // BVH_H
@@ -0,0 +1,144 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+struct Vec3 {
+    float x {}, y {}, z {};
+
+    Vec3() = default;
+    constexpr Vec3(float x, float y, float z)
+        : x(x)
+        , y(y)
+        , z(z)
+    {
+    }
+
+    float operator[](int axis) const { return (&x)[axis]; }
+    float& operator[](int axis) { return (&x)[axis]; }
+
+    Vec3 operator+(const Vec3& v) const { return { x + v.x, y + v.y, z + v.z }; }
+    Vec3 operator-(const Vec3& v) const { return { x - v.x, y - v.y, z - v.z }; }
+    Vec3 operator*(const Vec3& v) const { return { x * v.x, y * v.y, z * v.z }; }
+    Vec3 operator*(float s) const { return { x * s, y * s, z * s }; }
+};
+
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(const Vec3& a, const Vec3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+inline Vec3 min(const Vec3& a, const Vec3& b) { return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) }; }
+inline Vec3 max(const Vec3& a, const Vec3& b) { return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) }; }
+
+struct Aabb {
+    Vec3 min { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    Vec3 max { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+    void grow(const Vec3& p)
+    {
+        min = ::min(min, p);
+        max = ::max(max, p);
+    }
+
+    void grow(const Aabb& b)
+    {
+        min = ::min(min, b.min);
+        max = ::max(max, b.max);
+    }
+
+    bool isEmpty() const { return min.x > max.x; }
+    Vec3 extent() const { return max - min; }
+    Vec3 center() const { return (min + max) * 0.5f; }
+
+    float surfaceArea() const
+    {
+        if (isEmpty())
+            return 0.0f;
+        const Vec3 e = extent();
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    int longestAxis() const
+    {
+        const Vec3 e = extent();
+        return (e.x >= e.y && e.x >= e.z) ? 0 : (e.y >= e.z ? 1 : 2);
+    }
+
+    bool contains(const Vec3& p) const
+    {
+        return p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z;
+    }
+
+    bool overlaps(const Aabb& b) const
+    {
+        return min.x <= b.max.x && min.y <= b.max.y && min.z <= b.max.z && max.x >= b.min.x && max.y >= b.min.y && max.z >= b.min.z;
+    }
+};
+
+struct Ray {
+    Vec3 origin;
+    Vec3 dir;
+    float tMin = 0.0f;
+    float tMax = std::numeric_limits<float>::infinity();
+};
+
+// 1 / dir, infinities for zero components are fine for slab tests
+inline Vec3 safeInverse(const Vec3& dir)
+{
+    auto inv = [](float d) { return d != 0.0f ? 1.0f / d : std::copysign(std::numeric_limits<float>::infinity(), d); };
+    return { inv(dir.x), inv(dir.y), inv(dir.z) };
+}
+
+// slab test, returns entry distance or infinity if missed
+inline float intersectAabb(const Vec3& boxMin, const Vec3& boxMax, const Vec3& origin, const Vec3& invDir, float tMin, float tMax)
+{
+    const float tx1 = (boxMin.x - origin.x) * invDir.x, tx2 = (boxMax.x - origin.x) * invDir.x;
+    const float ty1 = (boxMin.y - origin.y) * invDir.y, ty2 = (boxMax.y - origin.y) * invDir.y;
+    const float tz1 = (boxMin.z - origin.z) * invDir.z, tz2 = (boxMax.z - origin.z) * invDir.z;
+    const float tEnter = std::max({ tMin, std::min(tx1, tx2), std::min(ty1, ty2), std::min(tz1, tz2) });
+    const float tExit = std::min({ tMax, std::max(tx1, tx2), std::max(ty1, ty2), std::max(tz1, tz2) });
+    return tEnter <= tExit ? tEnter : std::numeric_limits<float>::infinity();
+}
+
+struct Triangle {
+    Vec3 v0, v1, v2;
+
+    Aabb bounds() const
+    {
+        Aabb b;
+        b.grow(v0);
+        b.grow(v1);
+        b.grow(v2);
+        return b;
+    }
+
+    Vec3 centroid() const { return (v0 + v1 + v2) * (1.0f / 3.0f); }
+};
+
+// Moller-Trumbore, distance along ray or infinity, u v are barycentrics of v1 and v2
+inline float intersectTriangle(const Triangle& tri, const Ray& ray, float& u, float& v)
+{
+    constexpr float miss = std::numeric_limits<float>::infinity();
+    const Vec3 e1 = tri.v1 - tri.v0;
+    const Vec3 e2 = tri.v2 - tri.v0;
+    const Vec3 p = cross(ray.dir, e2);
+    const float det = dot(e1, p);
+    if (std::fabs(det) < 1e-12f)
+        return miss;
+
+    const float invDet = 1.0f / det;
+    const Vec3 s = ray.origin - tri.v0;
+    u = dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return miss;
+
+    const Vec3 q = cross(s, e1);
+    v = dot(ray.dir, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return miss;
+
+    const float t = dot(e2, q) * invDet;
+    return (t >= ray.tMin && t <= ray.tMax) ? t : miss;
+}
+
+#endif // GEOMETRY_H
@@ -0,0 +1,310 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../containers/arena_buffer.h"
+#include "../utils/thread_pool.h"
+#include "geometry.h"
+#include "simd_float.h"
+
+/* k-d tree over 3D points for kNN and radius queries
+ *
+ * Stored like DenseTreeNode: nodes depth-first in one ArenaBuffer, LEFT child is IMPLICIT (next node),
+ * right child is a RELATIVE offset (in nodes). KdTree header addresses nodes and leaf blocks relative to itself.
+ *
+ * Leaf buckets are runs of KdBlock, 8 points in SoA (x[8], y[8], z[8], index[8]),
+ * distances to 8 points are one SIMD computation (SimdFloat<8>, AVX or arrays).
+ * Padding lanes have infinite coordinates, so they are never closer than anything.
+ *
+ * Build: median split on the widest axis, O(N log N).
+ * kNN: bounded max-heap of k best, near child first, far child is skipped
+ * when the split plane is farther than the current k-th distance.
+ *
+ * size_t treeOffset = buildKdTree(buf, points, pointNum);
+ * const KdTree* tree = getKdTree(buf, treeOffset);
+ * KdNeighbor result[8];
+ * int found = kdNearest(tree, query, 8, result); // sorted by distance
+ */
+
+constexpr int kdBlockSize = 8;
+
+struct KdBlock {
+    alignas(32) float x[kdBlockSize];
+    alignas(32) float y[kdBlockSize];
+    alignas(32) float z[kdBlockSize];
+    uint32_t index[kdBlockSize]; // in the original point array
+};
+
+struct KdNode {
+    float split;
+    uint32_t rightOrBlock; // inner: offset to right child in nodes, leaf: first block
+    uint16_t pointNum; // 0 for inner node
+    uint8_t axis;
+
+    bool isLeaf() const { return pointNum != 0; }
+};
+
+struct KdTree {
+    uint32_t nodeNum;
+    uint32_t pointNum;
+    uint32_t blockNum;
+    uint64_t nodesRel;
+    uint64_t blocksRel;
+
+    const KdNode* getNodes() const { return (const KdNode*)((const uint8_t*)this + nodesRel); }
+    const KdBlock* getBlocks() const { return (const KdBlock*)((const uint8_t*)this + blocksRel); }
+};
+
+struct KdNeighbor {
+    float dist2;
+    uint32_t index;
+
+    bool operator<(const KdNeighbor& other) const { return dist2 < other.dist2; }
+};
+
+template <typename BufferType>
+const KdTree* getKdTree(const BufferType& buf, size_t treeOffset) { return (const KdTree*)(buf.data + treeOffset); }
+
+namespace kd_tree_detail {
+
+struct Builder {
+    const Vec3* points;
+    int maxLeafSize;
+    std::vector<uint32_t> order;
+    std::vector<KdNode> nodes;
+    std::vector<KdBlock> blocks;
+
+    void makeLeaf(uint32_t nodeIndex, uint32_t begin, uint32_t end)
+    {
+        nodes[nodeIndex].rightOrBlock = blocks.size();
+        nodes[nodeIndex].pointNum = end - begin;
+        for (uint32_t i = begin; i < end; i += kdBlockSize) {
+            KdBlock& block = blocks.emplace_back();
+            for (int lane = 0; lane < kdBlockSize; ++lane) {
+                const bool valid = i + lane < end;
+                const Vec3 p = valid ? points[order[i + lane]] : Vec3 { 1, 1, 1 } * std::numeric_limits<float>::infinity();
+                block.x[lane] = p.x, block.y[lane] = p.y, block.z[lane] = p.z;
+                block.index[lane] = valid ? order[i + lane] : UINT32_MAX;
+            }
+        }
+    }
+
+    void build(uint32_t begin, uint32_t end)
+    {
+        const uint32_t nodeIndex = nodes.size();
+        nodes.emplace_back();
+
+        if (end - begin <= (uint32_t)maxLeafSize) {
+            makeLeaf(nodeIndex, begin, end);
+            return;
+        }
+
+        Aabb bounds;
+        for (uint32_t i = begin; i < end; ++i)
+            bounds.grow(points[order[i]]);
+        const int axis = bounds.longestAxis();
+        if (bounds.extent()[axis] <= 0.0f && end - begin <= UINT16_MAX) { // all points equal
+            makeLeaf(nodeIndex, begin, end);
+            return;
+        }
+
+        const uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+            [&](uint32_t a, uint32_t b) { return points[a][axis] < points[b][axis]; });
+
+        nodes[nodeIndex].split = points[order[mid]][axis];
+        nodes[nodeIndex].axis = axis;
+        nodes[nodeIndex].pointNum = 0;
+        build(begin, mid);
+        nodes[nodeIndex].rightOrBlock = nodes.size() - nodeIndex;
+        build(mid, end);
+    }
+};
+
+// k best in a max-heap, top is the current k-th distance
+struct KnnHeap {
+    KdNeighbor* items;
+    int capacity;
+    int size = 0;
+
+    float worst() const { return size < capacity ? std::numeric_limits<float>::infinity() : items[0].dist2; }
+
+    void push(float dist2, uint32_t index)
+    {
+        if (size < capacity) {
+            items[size++] = { dist2, index };
+            std::push_heap(items, items + size);
+        } else if (dist2 < items[0].dist2) {
+            std::pop_heap(items, items + size);
+            items[size - 1] = { dist2, index };
+            std::push_heap(items, items + size);
+        }
+    }
+};
+
+inline SimdFloat<kdBlockSize> blockDistances(const KdBlock& block, const Vec3& q)
+{
+    using F = SimdFloat<kdBlockSize>;
+    const F dx = F::load(block.x) - F::broadcast(q.x);
+    const F dy = F::load(block.y) - F::broadcast(q.y);
+    const F dz = F::load(block.z) - F::broadcast(q.z);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// visitLeaf(node) for every leaf that may have points closer than maxDist2(), near child first
+template <typename MaxDist2, typename VisitLeaf>
+void traverse(const KdTree* tree, const Vec3& q, MaxDist2&& maxDist2, VisitLeaf&& visitLeaf)
+{
+    const KdNode* nodes = tree->getNodes();
+    struct Entry {
+        uint32_t node;
+        float planeDist2;
+    } stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0.0f };
+
+    while (stackSize) {
+        const Entry entry = stack[--stackSize];
+        if (entry.planeDist2 > maxDist2())
+            continue;
+
+        uint32_t current = entry.node;
+        while (!nodes[current].isLeaf()) {
+            const KdNode& node = nodes[current];
+            const float diff = q[node.axis] - node.split;
+            const uint32_t left = current + 1;
+            const uint32_t right = current + node.rightOrBlock;
+            const uint32_t near = diff < 0.0f ? left : right;
+            const uint32_t far = diff < 0.0f ? right : left;
+            // stack depth is tree depth, median splits keep it at log2(N / leafSize)
+            assert(stackSize < 64);
+            stack[stackSize++] = { far, std::max(entry.planeDist2, diff * diff) };
+            current = near;
+        }
+        visitLeaf(nodes[current]);
+    }
+}
+
+} // namespace kd_tree_detail
+
+template <typename BufferType>
+size_t buildKdTree(BufferType& buf, const Vec3* points, uint32_t pointNum, int maxLeafSize = 16)
+{
+    kd_tree_detail::Builder builder { points, std::clamp(maxLeafSize, 1, (int)UINT16_MAX), {}, {}, {} };
+    builder.order.resize(pointNum);
+    for (uint32_t i = 0; i < pointNum; ++i)
+        builder.order[i] = i;
+    builder.nodes.reserve(2 * (pointNum / builder.maxLeafSize) + 1);
+    builder.build(0, pointNum);
+
+    const size_t treeOffset = buf.template allocate<KdTree>(1);
+    const size_t nodesOffset = buf.template allocate<KdNode>(builder.nodes.size());
+    const size_t blocksOffset = buf.template allocate<KdBlock>(builder.blocks.size());
+
+    KdTree* tree = (KdTree*)(buf.data + treeOffset);
+    tree->nodeNum = builder.nodes.size();
+    tree->pointNum = pointNum;
+    tree->blockNum = builder.blocks.size();
+    tree->nodesRel = nodesOffset - treeOffset;
+    tree->blocksRel = blocksOffset - treeOffset;
+    std::copy(builder.nodes.begin(), builder.nodes.end(), (KdNode*)(buf.data + nodesOffset));
+    std::copy(builder.blocks.begin(), builder.blocks.end(), (KdBlock*)(buf.data + blocksOffset));
+    return treeOffset;
+}
+
+// k nearest points, result[k] sorted by distance, returns number found (min(k, pointNum))
+inline int kdNearest(const KdTree* tree, const Vec3& q, int k, KdNeighbor* result)
+{
+    if (k <= 0 || tree->pointNum == 0)
+        return 0;
+
+    using F = SimdFloat<kdBlockSize>;
+    const KdBlock* blocks = tree->getBlocks();
+    kd_tree_detail::KnnHeap heap { result, k };
+
+    kd_tree_detail::traverse(
+        tree, q, [&] { return heap.worst(); },
+        [&](const KdNode& leaf) {
+            const uint32_t blockEnd = leaf.rightOrBlock + (leaf.pointNum + kdBlockSize - 1) / kdBlockSize;
+            for (uint32_t b = leaf.rightOrBlock; b < blockEnd; ++b) {
+                alignas(32) float dist2[kdBlockSize];
+                const F d = kd_tree_detail::blockDistances(blocks[b], q);
+                int mask = (d < F::broadcast(heap.worst())).moveMask();
+                if (!mask)
+                    continue;
+                d.store(dist2);
+                while (mask) {
+                    const int lane = __builtin_ctz(mask);
+                    mask &= mask - 1;
+                    heap.push(dist2[lane], blocks[b].index[lane]);
+                }
+            }
+        });
+
+    std::sort_heap(result, result + heap.size);
+    return heap.size;
+}
+
+// all points with distance <= radius, appended to result unsorted
+inline void kdRadiusSearch(const KdTree* tree, const Vec3& q, float radius, std::vector<KdNeighbor>& result)
+{
+    if (tree->pointNum == 0)
+        return;
+
+    using F = SimdFloat<kdBlockSize>;
+    const KdBlock* blocks = tree->getBlocks();
+    const float radius2 = radius * radius;
+
+    kd_tree_detail::traverse(
+        tree, q, [&] { return radius2; },
+        [&](const KdNode& leaf) {
+            const uint32_t blockEnd = leaf.rightOrBlock + (leaf.pointNum + kdBlockSize - 1) / kdBlockSize;
+            for (uint32_t b = leaf.rightOrBlock; b < blockEnd; ++b) {
+                alignas(32) float dist2[kdBlockSize];
+                const F d = kd_tree_detail::blockDistances(blocks[b], q);
+                int mask = (d <= F::broadcast(radius2)).moveMask();
+                if (!mask)
+                    continue;
+                d.store(dist2);
+                while (mask) {
+                    const int lane = __builtin_ctz(mask);
+                    mask &= mask - 1;
+                    if (blocks[b].index[lane] != UINT32_MAX) // padding is at infinity, radius may be too
+                        result.push_back({ dist2[lane], blocks[b].index[lane] });
+                }
+            }
+        });
+}
+
+// results[q * k + i], rows shorter than k (less than k points) are padded with { inf, UINT32_MAX }
+inline void kdNearestBatch(ThreadPool& pool, const KdTree* tree, const Vec3* queries, uint32_t queryNum, int k, KdNeighbor* results)
+{
+    pool.parallelForRange(uint32_t(0), queryNum, [&](uint32_t b, uint32_t e) {
+        for (uint32_t q = b; q < e; ++q) {
+            KdNeighbor* row = results + (size_t)q * k;
+            const int found = kdNearest(tree, queries[q], k, row);
+            std::fill(row + found, row + k, KdNeighbor { std::numeric_limits<float>::infinity(), UINT32_MAX });
+        }
+    });
+}
+
+// results[q] is sorted by distance
+inline void kdRadiusSearchBatch(ThreadPool& pool, const KdTree* tree, const Vec3* queries, uint32_t queryNum, float radius,
+    std::vector<std::vector<KdNeighbor>>& results)
+{
+    results.resize(queryNum);
+    pool.parallelForRange(uint32_t(0), queryNum, [&](uint32_t b, uint32_t e) {
+        for (uint32_t q = b; q < e; ++q) {
+            results[q].clear();
+            kdRadiusSearch(tree, queries[q], radius, results[q]);
+            std::sort(results[q].begin(), results[q].end());
+        }
+    });
+}
+
+#endif // KD_TREE_H
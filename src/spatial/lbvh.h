@@ -0,0 +1,218 @@
+#ifndef LBVH_H
+#define LBVH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "../utils/radix_sort.h"
+#include "../utils/thread_pool.h"
+#include "bvh.h"
+#include "morton.h"
+
+/* Linear BVH (Karras 2012), for per-frame rebuilds
+ *
+ * 1. triangle centroids -> 30 bit (uint32_t) or 63 bit (uint64_t) Morton codes, SIMD
+ * 2. parallel LSD radix sort of (code, triangle index)
+ * 3. every internal node independently finds its key range and split from common prefixes
+ *    of neighbouring codes, in parallel, equal codes are told apart by their index
+ * 4. nodes are written in the same depth-first BvhNode layout as buildBvhSah:
+ *    node with leaf range [first, last] has 2 * (last - first + 1) - 1 nodes in its subtree,
+ *    so right child = parent + 2 * leftLeafNum, every subtree is contiguous.
+ *    Top of the tree is expanded serially until there are enough subtrees,
+ *    subtrees are written and refit (reverse sweep of their range) in parallel, then the top is refit.
+ *
+ * One triangle per leaf, quality is worse than SAH, build is O(N) after the sort.
+ * Traversal is shared: intersectBvh(getBvh(buf, offset), ray, hit).
+ */
+
+namespace lbvh_detail {
+
+struct KarrasNode {
+    uint32_t first, last, split; // leaf range, left child covers [first, split]
+};
+
+template <typename Code>
+inline int commonPrefix(const Code* codes, int64_t num, int64_t i, int64_t j)
+{
+    if (j < 0 || j >= num)
+        return -1;
+    const Code a = codes[i], b = codes[j];
+    if (a != b)
+        return sizeof(Code) == 8 ? __builtin_clzll(a ^ b) : __builtin_clz(a ^ b);
+    return int(sizeof(Code) * 8) + __builtin_clzll(uint64_t(i ^ j)) - 32; // indices fit in 32 bits
+}
+
+template <typename Code>
+KarrasNode findKarrasNode(const Code* codes, int64_t num, int64_t i)
+{
+    const int d = commonPrefix(codes, num, i, i + 1) > commonPrefix(codes, num, i, i - 1) ? 1 : -1;
+    const int minPrefix = commonPrefix(codes, num, i, i - d);
+
+    int64_t lengthMax = 2;
+    while (commonPrefix(codes, num, i, i + lengthMax * d) > minPrefix)
+        lengthMax *= 2;
+
+    int64_t length = 0;
+    for (int64_t t = lengthMax / 2; t >= 1; t /= 2)
+        if (commonPrefix(codes, num, i, i + (length + t) * d) > minPrefix)
+            length += t;
+    const int64_t j = i + length * d;
+
+    const int nodePrefix = commonPrefix(codes, num, i, j);
+    int64_t s = 0;
+    for (int64_t div = 2;; div *= 2) {
+        const int64_t t = (length + div - 1) / div;
+        if (commonPrefix(codes, num, i, i + (s + t) * d) > nodePrefix)
+            s += t;
+        if (t == 1)
+            break;
+    }
+    const int64_t split = i + s * d + std::min(d, 0);
+    return { (uint32_t)std::min(i, j), (uint32_t)std::max(i, j), (uint32_t)split };
+}
+
+// internal node of a range starts or ends at its own index
+inline uint32_t leftChild(const KarrasNode& n) { return n.split; }
+inline uint32_t rightChild(const KarrasNode& n) { return n.split + 1; }
+
+struct SubtreeRef {
+    uint32_t first, last; // leaf range, first == last is a leaf
+    uint32_t internal; // karras node index for internal nodes
+    uint32_t position; // dense position
+};
+
+inline SubtreeRef leftRef(const KarrasNode& n, uint32_t position)
+{
+    return { n.first, n.split, leftChild(n), position + 1 };
+}
+
+inline SubtreeRef rightRef(const KarrasNode& n, uint32_t position)
+{
+    return { n.split + 1, n.last, rightChild(n), position + 2 * (n.split - n.first + 1) };
+}
+
+inline void writeLeaf(BvhNode* nodes, const Triangle* triangles, const SubtreeRef& ref)
+{
+    BvhNode& node = nodes[ref.position];
+    node.setBounds(triangles[ref.first].bounds());
+    node.rightOrFirst = ref.first;
+    node.triangleNum = 1;
+}
+
+inline void writeInner(BvhNode* nodes, const KarrasNode& n, uint32_t position)
+{
+    nodes[position].rightOrFirst = 2 * (n.split - n.first + 1);
+    nodes[position].triangleNum = 0;
+}
+
+inline void refitInner(BvhNode* nodes, uint32_t position)
+{
+    BvhNode& node = nodes[position];
+    const BvhNode* l = node.getLeft();
+    const BvhNode* r = node.getRight();
+    node.setBounds({ min(l->getMin(), r->getMin()), max(l->getMax(), r->getMax()) });
+}
+
+} // namespace lbvh_detail
+
+template <typename Code = uint32_t, typename BufferType>
+size_t buildBvhLbvh(ThreadPool& pool, BufferType& buf, const Triangle* triangles, uint32_t triangleNum)
+{
+    using namespace lbvh_detail;
+
+    if (triangleNum == 0)
+        return buildBvhSah(buf, triangles, 0);
+
+    // centroids, SoA for SIMD Morton codes
+    std::vector<float> xs(triangleNum), ys(triangleNum), zs(triangleNum);
+    const int taskNum = pool.getThreadNum() * 4;
+    std::vector<Aabb> taskBounds(taskNum);
+    const size_t chunkSize = (triangleNum + taskNum - 1) / taskNum;
+    pool.parallelFor(taskNum, [&](int task) {
+        Aabb b;
+        const size_t end = std::min<size_t>(triangleNum, (task + 1) * chunkSize);
+        for (size_t i = task * chunkSize; i < end; ++i) {
+            const Vec3 c = triangles[i].centroid();
+            xs[i] = c.x, ys[i] = c.y, zs[i] = c.z;
+            b.grow(c);
+        }
+        taskBounds[task] = b;
+    });
+    Aabb centroidBounds;
+    for (const Aabb& b : taskBounds)
+        centroidBounds.grow(b);
+
+    std::vector<Code> codes(triangleNum);
+    std::vector<uint32_t> order(triangleNum);
+    pool.parallelForRange(size_t(0), size_t(triangleNum), [&](size_t b, size_t e) {
+        computeMortonCodes(xs.data() + b, ys.data() + b, zs.data() + b, e - b, centroidBounds, codes.data() + b);
+        std::iota(order.begin() + b, order.begin() + e, (uint32_t)b);
+    });
+    parallelRadixSortPairs(pool, codes.data(), order.data(), triangleNum, 3 * MortonTraits<Code>::bitsPerAxis);
+
+    const size_t bvhOffset = allocateBvh(buf, 2 * triangleNum - 1, triangleNum);
+    Bvh* bvh = (Bvh*)(buf.data + bvhOffset);
+    BvhNode* nodes = bvh->getNodes();
+    Triangle* sortedTriangles = bvh->getTriangles();
+    uint32_t* triangleIndices = bvh->getTriangleIndices();
+    pool.parallelForRange(uint32_t(0), triangleNum, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            sortedTriangles[i] = triangles[order[i]];
+            triangleIndices[i] = order[i];
+        }
+    });
+
+    // hierarchy, every internal node on its own
+    std::vector<KarrasNode> karras(triangleNum - 1);
+    pool.parallelForRange(uint32_t(0), triangleNum - 1, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i)
+            karras[i] = findKarrasNode(codes.data(), triangleNum, i);
+    });
+
+    // top of the tree, breadth first until there are enough subtrees
+    std::vector<SubtreeRef> queue { { 0, triangleNum - 1, 0, 0 } };
+    size_t head = 0;
+    const size_t subtreeNum = pool.getThreadNum() * 8;
+    while (head < queue.size() && queue.size() - head < subtreeNum) {
+        const SubtreeRef ref = queue[head];
+        if (ref.first == ref.last) // leaf stays in the frontier
+            break;
+        ++head;
+        const KarrasNode& n = karras[ref.internal];
+        writeInner(nodes, n, ref.position);
+        queue.push_back(leftRef(n, ref.position));
+        queue.push_back(rightRef(n, ref.position));
+    }
+
+    // frontier subtrees: depth-first write, then reverse sweep of the contiguous range is bottom-up
+    pool.parallelFor(queue.size() - head, [&](int task) {
+        const SubtreeRef root = queue[head + task];
+        std::vector<SubtreeRef> stack { root };
+        while (!stack.empty()) {
+            const SubtreeRef ref = stack.back();
+            stack.pop_back();
+            if (ref.first == ref.last) {
+                writeLeaf(nodes, sortedTriangles, ref);
+                continue;
+            }
+            const KarrasNode& n = karras[ref.internal];
+            writeInner(nodes, n, ref.position);
+            stack.push_back(rightRef(n, ref.position));
+            stack.push_back(leftRef(n, ref.position));
+        }
+        const uint32_t end = root.position + 2 * (root.last - root.first + 1) - 1;
+        for (uint32_t p = end; p-- > root.position;)
+            if (!nodes[p].isLeaf())
+                refitInner(nodes, p);
+    });
+
+    // top nodes were queued parent first
+    for (size_t i = head; i-- > 0;)
+        refitInner(nodes, queue[i].position);
+
+    return bvhOffset;
+}
+
+#endif // LBVH_H
@@ -0,0 +1,203 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "geometry.h"
+
+/* Morton (Z-order) codes
+ *
+ * 30 bit code: 10 bits per axis in uint32_t, 63 bit code: 21 bits per axis in uint64_t,
+ * 2D code (mortonEncode2): 32 bits per axis in uint64_t.
+ * Bits are interleaved as ...z1y1x1z0y0x0, so sorting by code sorts points along the Z curve.
+ *
+ * computeMortonCodes quantizes points to the grid of bounds and encodes 8 (30 bit) or 4 (63 bit)
+ * points per AVX2 iteration, points are SoA (xs, ys, zs).
+ */
+
+template <typename Code>
+struct MortonTraits;
+
+template <>
+struct MortonTraits<uint32_t> {
+    static constexpr int bitsPerAxis = 10;
+};
+
+template <>
+struct MortonTraits<uint64_t> {
+    static constexpr int bitsPerAxis = 21;
+};
+
+// 10 bits -> every 3rd bit of 30
+inline constexpr uint32_t mortonExpandBits(uint32_t v)
+{
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+// 21 bits -> every 3rd bit of 63
+inline constexpr uint64_t mortonExpandBits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | (v << 32)) & 0x001f00000000ffffull;
+    v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+    v = (v | (v << 8)) & 0x100f00f00f00f00full;
+    v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+// every 3rd bit -> packed, inverse of mortonExpandBits
+inline constexpr uint32_t mortonCompactBits(uint32_t v)
+{
+    v &= 0x09249249;
+    v = (v | (v >> 2)) & 0x030c30c3;
+    v = (v | (v >> 4)) & 0x0300f00f;
+    v = (v | (v >> 8)) & 0x030000ff;
+    v = (v | (v >> 16)) & 0x3ff;
+    return v;
+}
+
+inline constexpr uint64_t mortonCompactBits(uint64_t v)
+{
+    v &= 0x1249249249249249ull;
+    v = (v | (v >> 2)) & 0x10c30c30c30c30c3ull;
+    v = (v | (v >> 4)) & 0x100f00f00f00f00full;
+    v = (v | (v >> 8)) & 0x001f0000ff0000ffull;
+    v = (v | (v >> 16)) & 0x001f00000000ffffull;
+    v = (v | (v >> 32)) & 0x1fffff;
+    return v;
+}
+
+template <typename Code>
+inline constexpr Code mortonEncode(Code x, Code y, Code z)
+{
+    return mortonExpandBits(x) | (mortonExpandBits(y) << 1) | (mortonExpandBits(z) << 2);
+}
+
+template <typename Code>
+inline constexpr void mortonDecode(Code code, Code& x, Code& y, Code& z)
+{
+    x = mortonCompactBits(code);
+    y = mortonCompactBits(Code(code >> 1));
+    z = mortonCompactBits(Code(code >> 2));
+}
+
+// 2D: 32 bits -> every 2nd bit of 64
+inline constexpr uint64_t mortonExpandBits2(uint64_t v)
+{
+    v &= 0xffffffff;
+    v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+    v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+    v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+inline constexpr uint64_t mortonEncode2(uint64_t x, uint64_t y) { return mortonExpandBits2(x) | (mortonExpandBits2(y) << 1); }
+
+namespace morton_detail {
+
+template <typename Code>
+constexpr float maxCell = float((1u << MortonTraits<Code>::bitsPerAxis) - 1);
+
+// position in [0, maxCell] -> grid cell, same rounding as the SIMD path
+template <typename Code>
+inline Code quantize(float v)
+{
+    return Code(std::min(std::max(v, 0.0f), maxCell<Code>));
+}
+
+#ifdef __AVX2__
+inline __m256i quantize8(__m256 v, __m256 offset, __m256 scale)
+{
+    const __m256 cellMax = _mm256_set1_ps(morton_detail::maxCell<uint32_t>);
+    const __m256 cell = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(v, offset), scale), _mm256_setzero_ps()), cellMax);
+    return _mm256_cvttps_epi32(cell);
+}
+
+inline __m256i expandBits8(__m256i v)
+{
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 16)), _mm256_set1_epi32(0x030000ff));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 8)), _mm256_set1_epi32(0x0300f00f));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 4)), _mm256_set1_epi32(0x030c30c3));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 2)), _mm256_set1_epi32(0x09249249));
+    return v;
+}
+
+// 4 floats -> 4 x 21 bit cells in 64 bit lanes
+inline __m256i quantize4(__m128 v, __m128 offset, __m128 scale)
+{
+    const __m128 cellMax = _mm_set1_ps(morton_detail::maxCell<uint64_t>);
+    const __m128 cell = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(v, offset), scale), _mm_setzero_ps()), cellMax);
+    return _mm256_cvtepu32_epi64(_mm_cvttps_epi32(cell));
+}
+
+inline __m256i expandBits4(__m256i v)
+{
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 32)), _mm256_set1_epi64x(0x001f00000000ffffll));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 16)), _mm256_set1_epi64x(0x001f0000ff0000ffll));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 8)), _mm256_set1_epi64x(0x100f00f00f00f00fll));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 4)), _mm256_set1_epi64x(0x10c30c30c30c30c3ll));
+    v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi64(v, 2)), _mm256_set1_epi64x(0x1249249249249249ll));
+    return v;
+}
+#endif
+
+} // namespace morton_detail
+
+// codes[i] for point (xs[i], ys[i], zs[i]) quantized to the grid of bounds
+template <typename Code>
+void computeMortonCodes(const float* xs, const float* ys, const float* zs, size_t num, const Aabb& bounds, Code* codes)
+{
+    static_assert(std::is_same_v<Code, uint32_t> || std::is_same_v<Code, uint64_t>);
+    const Vec3 extent = bounds.extent();
+    constexpr float maxCell = morton_detail::maxCell<Code>;
+    const Vec3 scale { extent.x > 0 ? maxCell / extent.x : 0.0f, extent.y > 0 ? maxCell / extent.y : 0.0f, extent.z > 0 ? maxCell / extent.z : 0.0f };
+
+    size_t i = 0;
+#ifdef __AVX2__
+    if constexpr (std::is_same_v<Code, uint32_t>) {
+        const __m256 ox = _mm256_set1_ps(bounds.min.x), sx = _mm256_set1_ps(scale.x);
+        const __m256 oy = _mm256_set1_ps(bounds.min.y), sy = _mm256_set1_ps(scale.y);
+        const __m256 oz = _mm256_set1_ps(bounds.min.z), sz = _mm256_set1_ps(scale.z);
+        for (; i + 8 <= num; i += 8) {
+            const __m256i x = morton_detail::expandBits8(morton_detail::quantize8(_mm256_loadu_ps(xs + i), ox, sx));
+            const __m256i y = morton_detail::expandBits8(morton_detail::quantize8(_mm256_loadu_ps(ys + i), oy, sy));
+            const __m256i z = morton_detail::expandBits8(morton_detail::quantize8(_mm256_loadu_ps(zs + i), oz, sz));
+            const __m256i code = _mm256_or_si256(x, _mm256_or_si256(_mm256_slli_epi32(y, 1), _mm256_slli_epi32(z, 2)));
+            _mm256_storeu_si256((__m256i*)(codes + i), code);
+        }
+    } else {
+        const __m128 ox = _mm_set1_ps(bounds.min.x), sx = _mm_set1_ps(scale.x);
+        const __m128 oy = _mm_set1_ps(bounds.min.y), sy = _mm_set1_ps(scale.y);
+        const __m128 oz = _mm_set1_ps(bounds.min.z), sz = _mm_set1_ps(scale.z);
+        for (; i + 4 <= num; i += 4) {
+            const __m256i x = morton_detail::expandBits4(morton_detail::quantize4(_mm_loadu_ps(xs + i), ox, sx));
+            const __m256i y = morton_detail::expandBits4(morton_detail::quantize4(_mm_loadu_ps(ys + i), oy, sy));
+            const __m256i z = morton_detail::expandBits4(morton_detail::quantize4(_mm_loadu_ps(zs + i), oz, sz));
+            const __m256i code = _mm256_or_si256(x, _mm256_or_si256(_mm256_slli_epi64(y, 1), _mm256_slli_epi64(z, 2)));
+            _mm256_storeu_si256((__m256i*)(codes + i), code);
+        }
+    }
+#endif
+    for (; i < num; ++i)
+        codes[i] = mortonEncode<Code>(
+            morton_detail::quantize<Code>((xs[i] - bounds.min.x) * scale.x),
+            morton_detail::quantize<Code>((ys[i] - bounds.min.y) * scale.y),
+            morton_detail::quantize<Code>((zs[i] - bounds.min.z) * scale.z));
+}
+
+#endif // MORTON_H
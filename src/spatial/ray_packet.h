@@ -0,0 +1,219 @@
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "bvh.h"
+#include "simd_float.h"
+
+/* Ray packets, 4 or 8 rays traverse a binary Bvh together
+ *
+ * Rays are SoA, every node box and every triangle is tested against all rays of the packet
+ * with one SIMD instruction sequence (SSE for 4, AVX for 8). The packet descends into a child
+ * if any active ray hits it, so it pays off for coherent rays (primary rays of neighbouring pixels),
+ * incoherent packets degrade to the union of single ray traversals.
+ *
+ * Children are visited in the order most rays of the packet would visit them,
+ * stack entries keep per-ray entry distances, so entries behind all current hits are culled.
+ *
+ * RayPacket<8> packet; ... fill 8 rays
+ * PacketHit<8> hits;
+ * int hitMask = intersectBvhPacket(bvh, packet, hits);
+ */
+
+template <int Width>
+struct RayPacket {
+    alignas(32) float originX[Width], originY[Width], originZ[Width];
+    alignas(32) float dirX[Width], dirY[Width], dirZ[Width];
+    alignas(32) float tMin[Width], tMax[Width];
+
+    void setRay(int lane, const Ray& ray)
+    {
+        originX[lane] = ray.origin.x, originY[lane] = ray.origin.y, originZ[lane] = ray.origin.z;
+        dirX[lane] = ray.dir.x, dirY[lane] = ray.dir.y, dirZ[lane] = ray.dir.z;
+        tMin[lane] = ray.tMin, tMax[lane] = ray.tMax;
+    }
+};
+
+template <int Width>
+struct PacketHit {
+    alignas(32) float t[Width], u[Width], v[Width];
+    uint32_t triangle[Width]; // index in the original triangle array, UINT32_MAX if missed
+};
+
+namespace ray_packet_detail {
+
+template <int Width>
+struct SimdVec3 {
+    using F = SimdFloat<Width>;
+    F x, y, z;
+
+    static SimdVec3 broadcast(const Vec3& v) { return { F::broadcast(v.x), F::broadcast(v.y), F::broadcast(v.z) }; }
+    SimdVec3 operator-(const SimdVec3& b) const { return { x - b.x, y - b.y, z - b.z }; }
+};
+
+inline float floatFromBits(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+template <int Width>
+SimdFloat<Width> dot(const SimdVec3<Width>& a, const SimdVec3<Width>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+template <int Width>
+SimdVec3<Width> cross(const SimdVec3<Width>& a, const SimdVec3<Width>& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+template <int Width>
+SimdFloat<Width> intersectBox(const BvhNode& node, const SimdVec3<Width>& origin, const SimdVec3<Width>& invDir,
+    const SimdFloat<Width>& tMin, const SimdFloat<Width>& tMax, SimdFloat<Width>& tEnter)
+{
+    using F = SimdFloat<Width>;
+    const F tx1 = (F::broadcast(node.boundsMin[0]) - origin.x) * invDir.x, tx2 = (F::broadcast(node.boundsMax[0]) - origin.x) * invDir.x;
+    const F ty1 = (F::broadcast(node.boundsMin[1]) - origin.y) * invDir.y, ty2 = (F::broadcast(node.boundsMax[1]) - origin.y) * invDir.y;
+    const F tz1 = (F::broadcast(node.boundsMin[2]) - origin.z) * invDir.z, tz2 = (F::broadcast(node.boundsMax[2]) - origin.z) * invDir.z;
+    tEnter = max(max(min(tx1, tx2), min(ty1, ty2)), max(min(tz1, tz2), tMin));
+    const F tExit = min(min(max(tx1, tx2), max(ty1, ty2)), min(max(tz1, tz2), tMax));
+    return tEnter <= tExit;
+}
+
+} // namespace ray_packet_detail
+
+// returns mask of rays that hit something, hits are closest hits in [tMin, tMax] of every ray
+template <int Width>
+int intersectBvhPacket(const Bvh* bvh, const RayPacket<Width>& packet, PacketHit<Width>& hits)
+{
+    using namespace ray_packet_detail;
+    using F = SimdFloat<Width>;
+    using V = SimdVec3<Width>;
+
+    for (int i = 0; i < Width; ++i) {
+        hits.t[i] = std::numeric_limits<float>::infinity();
+        hits.triangle[i] = UINT32_MAX;
+    }
+    if (bvh->triangleNum == 0)
+        return 0;
+
+    const BvhNode* nodes = bvh->getNodes();
+    const Triangle* triangles = bvh->getTriangles();
+
+    const V origin { F::load(packet.originX), F::load(packet.originY), F::load(packet.originZ) };
+    const V dir { F::load(packet.dirX), F::load(packet.dirY), F::load(packet.dirZ) };
+    alignas(32) float inv[3][Width];
+    for (int i = 0; i < Width; ++i) {
+        const Vec3 v = safeInverse({ packet.dirX[i], packet.dirY[i], packet.dirZ[i] });
+        inv[0][i] = v.x, inv[1][i] = v.y, inv[2][i] = v.z;
+    }
+    const V invDir { F::load(inv[0]), F::load(inv[1]), F::load(inv[2]) };
+    const F tMin = F::load(packet.tMin);
+    F tMax = F::load(packet.tMax);
+    F hitT = F::broadcast(std::numeric_limits<float>::infinity()), hitU = F::broadcast(0.0f), hitV = F::broadcast(0.0f);
+    F hitIndex = F::broadcast(floatFromBits(UINT32_MAX)); // local triangle index, as bits
+
+    struct Entry {
+        uint32_t node;
+        F tEnter; // per ray, +inf for rays that missed the node
+    } stack[bvhStackSize];
+    int stackSize = 0;
+
+    const F inf = F::broadcast(std::numeric_limits<float>::infinity());
+    F rootEnter;
+    const F rootMask = intersectBox(nodes[0], origin, invDir, tMin, tMax, rootEnter);
+    if (!rootMask.moveMask())
+        return 0;
+    stack[stackSize++] = { 0, select(rootMask, rootEnter, inf) };
+
+    while (stackSize) {
+        const Entry entry = stack[--stackSize];
+        if (!(entry.tEnter < tMax).moveMask()) // behind hits of all rays
+            continue;
+
+        uint32_t current = entry.node;
+        while (true) {
+            const BvhNode& node = nodes[current];
+            if (node.isLeaf()) {
+                for (uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.triangleNum; ++i) {
+                    // Moller-Trumbore for all rays at once
+                    const Triangle& tri = triangles[i];
+                    const V e1 = V::broadcast(tri.v1 - tri.v0);
+                    const V e2 = V::broadcast(tri.v2 - tri.v0);
+                    const V p = cross(dir, e2);
+                    const F det = dot(e1, p);
+                    const F invDet = F::broadcast(1.0f) / det;
+                    const V s = origin - V::broadcast(tri.v0);
+                    const F u = dot(s, p) * invDet;
+                    const V q = cross(s, e1);
+                    const F v = dot(dir, q) * invDet;
+                    const F t = dot(e2, q) * invDet;
+                    const F zero = F::broadcast(0.0f), one = F::broadcast(1.0f);
+                    const F mask = (F::broadcast(1e-24f) < det * det) & (zero <= u) & (zero <= v) & (u + v <= one)
+                        & (tMin <= t) & (t < tMax);
+                    if (mask.moveMask()) {
+                        tMax = select(mask, t, tMax);
+                        hitT = select(mask, t, hitT);
+                        hitU = select(mask, u, hitU);
+                        hitV = select(mask, v, hitV);
+                        hitIndex = select(mask, F::broadcast(floatFromBits(i)), hitIndex);
+                    }
+                }
+                break;
+            }
+
+            const uint32_t left = current + 1;
+            const uint32_t right = current + node.rightOrFirst;
+            F tl, tr;
+            const F hitLeft = intersectBox(nodes[left], origin, invDir, tMin, tMax, tl);
+            const F hitRight = intersectBox(nodes[right], origin, invDir, tMin, tMax, tr);
+            const int ml = hitLeft.moveMask();
+            const int mr = hitRight.moveMask();
+            if (ml && mr) {
+                // order most rays agree on
+                const int leftCloser = (tl <= tr).moveMask() & ml & mr;
+                const bool leftFirst = __builtin_popcount(leftCloser) * 2 >= __builtin_popcount(ml & mr);
+                assert(stackSize < bvhStackSize);
+                if (leftFirst) {
+                    stack[stackSize++] = { right, select(hitRight, tr, inf) };
+                    current = left;
+                } else {
+                    stack[stackSize++] = { left, select(hitLeft, tl, inf) };
+                    current = right;
+                }
+                continue;
+            }
+            if (ml) {
+                current = left;
+                continue;
+            }
+            if (mr) {
+                current = right;
+                continue;
+            }
+            break;
+        }
+    }
+
+    alignas(32) float hitIndexBits[Width];
+    hitT.store(hits.t);
+    hitU.store(hits.u);
+    hitV.store(hits.v);
+    hitIndex.store(hitIndexBits);
+    int hitMask = 0;
+    for (int i = 0; i < Width; ++i) {
+        uint32_t local;
+        memcpy(&local, &hitIndexBits[i], sizeof(local));
+        if (local != UINT32_MAX) {
+            hits.triangle[i] = bvh->getTriangleIndices()[local];
+            hitMask |= 1 << i;
+        }
+    }
+    return hitMask;
+}
+
+#endif // RAY_PACKET_H
@@ -0,0 +1,151 @@
+#ifndef SIMD_FLOAT_H
+#define SIMD_FLOAT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+/* W floats in one register, for spatial queries that test W boxes or W rays at once
+ *
+ * SimdFloat<4> is SSE, SimdFloat<8> is AVX, other widths (or no SSE/AVX) are plain arrays.
+ * Comparisons return masks as SimdFloat with all bits set in true lanes,
+ * moveMask() packs lane signs into an int like _mm_movemask_ps.
+ */
+
+template <int W>
+struct SimdFloat {
+    float v[W];
+
+    static SimdFloat load(const float* p)
+    {
+        SimdFloat r;
+        std::copy(p, p + W, r.v);
+        return r;
+    }
+
+    static SimdFloat broadcast(float x)
+    {
+        SimdFloat r;
+        std::fill(r.v, r.v + W, x);
+        return r;
+    }
+
+    void store(float* p) const { std::copy(v, v + W, p); }
+
+    template <typename Op>
+    static SimdFloat map(const SimdFloat& a, const SimdFloat& b, Op op)
+    {
+        SimdFloat r;
+        for (int i = 0; i < W; ++i)
+            r.v[i] = op(a.v[i], b.v[i]);
+        return r;
+    }
+
+    static float fromBits(uint32_t bits)
+    {
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    static uint32_t toBits(float f)
+    {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    }
+
+    template <typename Cmp>
+    static SimdFloat compare(const SimdFloat& a, const SimdFloat& b, Cmp cmp)
+    {
+        return map(a, b, [&](float x, float y) { return fromBits(cmp(x, y) ? ~0u : 0u); });
+    }
+
+    template <typename Op>
+    static SimdFloat bitwise(const SimdFloat& a, const SimdFloat& b, Op op)
+    {
+        return map(a, b, [&](float x, float y) { return fromBits(op(toBits(x), toBits(y))); });
+    }
+
+    friend SimdFloat operator+(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x + y; }); }
+    friend SimdFloat operator-(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x - y; }); }
+    friend SimdFloat operator*(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x * y; }); }
+    friend SimdFloat operator/(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x / y; }); }
+    friend SimdFloat min(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    friend SimdFloat max(const SimdFloat& a, const SimdFloat& b) { return map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    friend SimdFloat operator<(const SimdFloat& a, const SimdFloat& b) { return compare(a, b, [](float x, float y) { return x < y; }); }
+    friend SimdFloat operator<=(const SimdFloat& a, const SimdFloat& b) { return compare(a, b, [](float x, float y) { return x <= y; }); }
+    friend SimdFloat operator&(const SimdFloat& a, const SimdFloat& b) { return bitwise(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+    friend SimdFloat operator|(const SimdFloat& a, const SimdFloat& b) { return bitwise(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+
+    // mask ? a : b
+    friend SimdFloat select(const SimdFloat& mask, const SimdFloat& a, const SimdFloat& b)
+    {
+        SimdFloat r;
+        for (int i = 0; i < W; ++i)
+            r.v[i] = (toBits(mask.v[i]) >> 31) ? a.v[i] : b.v[i];
+        return r;
+    }
+
+    int moveMask() const
+    {
+        int mask = 0;
+        for (int i = 0; i < W; ++i)
+            mask |= int(toBits(v[i]) >> 31) << i;
+        return mask;
+    }
+};
+
+#ifdef __SSE2__
+template <>
+struct SimdFloat<4> {
+    __m128 v;
+
+    static SimdFloat load(const float* p) { return { _mm_loadu_ps(p) }; }
+    static SimdFloat broadcast(float x) { return { _mm_set1_ps(x) }; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm_add_ps(a.v, b.v) }; }
+    friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+    friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+    friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm_div_ps(a.v, b.v) }; }
+    friend SimdFloat min(SimdFloat a, SimdFloat b) { return { _mm_min_ps(a.v, b.v) }; }
+    friend SimdFloat max(SimdFloat a, SimdFloat b) { return { _mm_max_ps(a.v, b.v) }; }
+    friend SimdFloat operator<(SimdFloat a, SimdFloat b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+    friend SimdFloat operator<=(SimdFloat a, SimdFloat b) { return { _mm_cmple_ps(a.v, b.v) }; }
+    friend SimdFloat operator&(SimdFloat a, SimdFloat b) { return { _mm_and_ps(a.v, b.v) }; }
+    friend SimdFloat operator|(SimdFloat a, SimdFloat b) { return { _mm_or_ps(a.v, b.v) }; }
+    friend SimdFloat select(SimdFloat mask, SimdFloat a, SimdFloat b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+    int moveMask() const { return _mm_movemask_ps(v); }
+};
+#endif
+
+#ifdef __AVX__
+template <>
+struct SimdFloat<8> {
+    __m256 v;
+
+    static SimdFloat load(const float* p) { return { _mm256_loadu_ps(p) }; }
+    static SimdFloat broadcast(float x) { return { _mm256_set1_ps(x) }; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+    friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+    friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+    friend SimdFloat min(SimdFloat a, SimdFloat b) { return { _mm256_min_ps(a.v, b.v) }; }
+    friend SimdFloat max(SimdFloat a, SimdFloat b) { return { _mm256_max_ps(a.v, b.v) }; }
+    friend SimdFloat operator<(SimdFloat a, SimdFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    friend SimdFloat operator<=(SimdFloat a, SimdFloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+    friend SimdFloat operator&(SimdFloat a, SimdFloat b) { return { _mm256_and_ps(a.v, b.v) }; }
+    friend SimdFloat operator|(SimdFloat a, SimdFloat b) { return { _mm256_or_ps(a.v, b.v) }; }
+    friend SimdFloat select(SimdFloat mask, SimdFloat a, SimdFloat b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    int moveMask() const { return _mm256_movemask_ps(v); }
+};
+#endif
+
+#endif // SIMD_FLOAT_H
@@ -0,0 +1,367 @@
+#ifndef SPARSE_TREE_H
+#define SPARSE_TREE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../containers/arena_buffer.h"
+#include "../utils/radix_sort.h"
+#include "../utils/thread_pool.h"
+#include "morton.h"
+
+/* Sparse octree (Dim = 3) / quadtree (Dim = 2) over points
+ *
+ * Only occupied cells have nodes. Node has a child mask (bit i = child cell i exists)
+ * and one RELATIVE offset (in nodes) to its children, children of a node are PACKED
+ * next to each other in child order, child i is at childrenRel + popcount(mask & ((1 << i) - 1)).
+ * Child cell i is in the upper half of axis a if bit a of i is set (same bit order as Morton codes).
+ *
+ * Bulk build: points -> Morton codes in the bounding cube, parallel radix sort, then every node
+ * is a contiguous range of sorted codes, children are split by the next Dim bits of the code.
+ * Points of every subtree are contiguous in the sorted point array, so range queries
+ * take whole subtrees without descending. Header, nodes and points are relative to the header.
+ *
+ * size_t treeOffset = buildSparseTree<3>(pool, buf, points, pointNum);
+ * const Octree* tree = getSparseTree<3>(buf, treeOffset);
+ * forEachPointInBox(tree, boxMin, boxMax, [&](uint32_t index, const SparsePoint<3>& p) { ... });
+ */
+
+template <int Dim>
+using SparsePoint = std::array<float, Dim>;
+
+struct SparseTreeNode {
+    uint32_t childrenRel; // offset to the first child in nodes, 0 for leaves
+    uint32_t firstPoint; // subtree points are [firstPoint, firstPoint + pointNum) in sorted points
+    uint32_t pointNum;
+    uint8_t childMask;
+    uint8_t level; // root is 0, cell size is tree size / 2^level
+
+    bool isLeaf() const { return childMask == 0; }
+    bool hasChild(int i) const { return childMask & (1u << i); }
+    const SparseTreeNode* getChild(int i) const { return this + childrenRel + __builtin_popcount(childMask & ((1u << i) - 1)); }
+};
+
+template <int Dim>
+struct SparseTree {
+    static_assert(Dim == 2 || Dim == 3);
+    static constexpr int childNum = 1 << Dim;
+    static constexpr int maxLevel = Dim == 3 ? 21 : 31; // Morton bits per axis
+    using Point = SparsePoint<Dim>;
+
+    uint32_t nodeNum;
+    uint32_t pointNum;
+    float origin[Dim]; // cube of the root cell
+    float size;
+    uint64_t nodesRel;
+    uint64_t pointsRel;
+    uint64_t pointIndicesRel;
+
+    const SparseTreeNode* getNodes() const { return (const SparseTreeNode*)((const uint8_t*)this + nodesRel); }
+    const SparsePoint<Dim>* getPoints() const { return (const SparsePoint<Dim>*)((const uint8_t*)this + pointsRel); }
+    const uint32_t* getPointIndices() const { return (const uint32_t*)((const uint8_t*)this + pointIndicesRel); }
+};
+
+using Quadtree = SparseTree<2>;
+using Octree = SparseTree<3>;
+
+template <int Dim, typename BufferType>
+const SparseTree<Dim>* getSparseTree(const BufferType& buf, size_t treeOffset) { return (const SparseTree<Dim>*)(buf.data + treeOffset); }
+
+namespace sparse_tree_detail {
+
+template <int Dim>
+uint64_t encode(const SparseTree<Dim>& tree, const SparsePoint<Dim>& p)
+{
+    constexpr double cellNum = double(1ull << SparseTree<Dim>::maxLevel);
+    uint64_t cell[Dim];
+    for (int a = 0; a < Dim; ++a) {
+        const double c = (double(p[a]) - tree.origin[a]) / tree.size * cellNum;
+        cell[a] = (uint64_t)std::clamp(c, 0.0, cellNum - 1);
+    }
+    if constexpr (Dim == 3)
+        return mortonEncode<uint64_t>(cell[0], cell[1], cell[2]);
+    else
+        return mortonEncode2(cell[0], cell[1]);
+}
+
+template <int Dim>
+int childDigit(uint64_t code, int level) { return (code >> ((SparseTree<Dim>::maxLevel - 1 - level) * Dim)) & ((1 << Dim) - 1); }
+
+template <int Dim>
+struct Builder {
+    const uint64_t* codes; // sorted
+    int maxLeafSize;
+    int maxLevel;
+    std::vector<SparseTreeNode> nodes;
+
+    void build(uint32_t nodeIndex, uint32_t begin, uint32_t end, int level)
+    {
+        nodes[nodeIndex].firstPoint = begin;
+        nodes[nodeIndex].pointNum = end - begin;
+        nodes[nodeIndex].level = level;
+        if (end - begin <= (uint32_t)maxLeafSize || level == maxLevel)
+            return;
+
+        uint32_t bounds[(1 << Dim) + 1]; // child i is [bounds[i], bounds[i + 1])
+        bounds[0] = begin;
+        for (int i = 0; i < (1 << Dim); ++i)
+            bounds[i + 1] = std::partition_point(codes + bounds[i], codes + end,
+                                [&](uint64_t code) { return childDigit<Dim>(code, level) <= i; })
+                - codes;
+
+        uint8_t mask = 0;
+        for (int i = 0; i < (1 << Dim); ++i)
+            if (bounds[i] != bounds[i + 1])
+                mask |= 1u << i;
+
+        const uint32_t childrenBegin = nodes.size();
+        nodes.resize(childrenBegin + __builtin_popcount(mask));
+        nodes[nodeIndex].childMask = mask;
+        nodes[nodeIndex].childrenRel = childrenBegin - nodeIndex;
+
+        uint32_t child = childrenBegin;
+        for (int i = 0; i < (1 << Dim); ++i)
+            if (mask & (1u << i))
+                build(child++, bounds[i], bounds[i + 1], level + 1);
+    }
+};
+
+template <int Dim>
+struct Cell {
+    float min[Dim];
+    float size;
+
+    Cell child(int i) const
+    {
+        Cell c;
+        c.size = size * 0.5f;
+        for (int a = 0; a < Dim; ++a)
+            c.min[a] = min[a] + ((i >> a) & 1) * c.size;
+        return c;
+    }
+};
+
+template <int Dim>
+Cell<Dim> rootCell(const SparseTree<Dim>* tree)
+{
+    Cell<Dim> c;
+    std::copy(tree->origin, tree->origin + Dim, c.min);
+    c.size = tree->size;
+    return c;
+}
+
+} // namespace sparse_tree_detail
+
+// maxLevel limits depth (and cell size), leaves at maxLevel may hold more than maxLeafSize points
+template <int Dim, typename BufferType>
+size_t buildSparseTree(ThreadPool& pool, BufferType& buf, const SparsePoint<Dim>* points, uint32_t pointNum,
+    int maxLeafSize = 8, int maxLevel = SparseTree<Dim>::maxLevel)
+{
+    using Tree = SparseTree<Dim>;
+
+    // bounding cube, slightly grown so max points are inside the last cell
+    float lo[Dim], hi[Dim];
+    std::fill(lo, lo + Dim, std::numeric_limits<float>::max());
+    std::fill(hi, hi + Dim, std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < pointNum; ++i)
+        for (int a = 0; a < Dim; ++a) {
+            lo[a] = std::min(lo[a], points[i][a]);
+            hi[a] = std::max(hi[a], points[i][a]);
+        }
+    float size = 0.0f;
+    for (int a = 0; a < Dim; ++a)
+        size = std::max(size, hi[a] - lo[a]);
+    size = size > 0.0f ? size * 1.0001f : 1.0f;
+
+    Tree header {};
+    header.pointNum = pointNum;
+    header.size = size;
+    for (int a = 0; a < Dim; ++a)
+        header.origin[a] = pointNum ? lo[a] : 0.0f;
+
+    std::vector<uint64_t> codes(pointNum);
+    std::vector<uint32_t> order(pointNum);
+    pool.parallelForRange(uint32_t(0), pointNum, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            codes[i] = sparse_tree_detail::encode<Dim>(header, points[i]);
+            order[i] = i;
+        }
+    });
+    parallelRadixSortPairs(pool, codes.data(), order.data(), pointNum, Dim * Tree::maxLevel);
+
+    sparse_tree_detail::Builder<Dim> builder { codes.data(), std::max(1, maxLeafSize), std::clamp(maxLevel, 0, Tree::maxLevel), {} };
+    builder.nodes.reserve(pointNum / builder.maxLeafSize * 2 + 1);
+    builder.nodes.emplace_back();
+    builder.build(0, 0, pointNum, 0);
+
+    const size_t treeOffset = buf.template allocate<Tree>(1);
+    const size_t nodesOffset = buf.template allocate<SparseTreeNode>(builder.nodes.size());
+    const size_t pointsOffset = buf.template allocate<SparsePoint<Dim>>(pointNum);
+    const size_t indicesOffset = buf.template allocate<uint32_t>(pointNum);
+
+    Tree* tree = (Tree*)(buf.data + treeOffset);
+    *tree = header;
+    tree->nodeNum = builder.nodes.size();
+    tree->nodesRel = nodesOffset - treeOffset;
+    tree->pointsRel = pointsOffset - treeOffset;
+    tree->pointIndicesRel = indicesOffset - treeOffset;
+    std::copy(builder.nodes.begin(), builder.nodes.end(), (SparseTreeNode*)(buf.data + nodesOffset));
+
+    SparsePoint<Dim>* sortedPoints = (SparsePoint<Dim>*)(buf.data + pointsOffset);
+    uint32_t* indices = (uint32_t*)(buf.data + indicesOffset);
+    pool.parallelForRange(uint32_t(0), pointNum, [&](uint32_t b, uint32_t e) {
+        for (uint32_t i = b; i < e; ++i) {
+            sortedPoints[i] = points[order[i]];
+            indices[i] = order[i];
+        }
+    });
+    return treeOffset;
+}
+
+// deepest node whose cell contains p, nullptr if p is outside the tree or in an empty cell
+template <int Dim>
+const SparseTreeNode* locatePoint(const SparseTree<Dim>* tree, const typename SparseTree<Dim>::Point& p)
+{
+    for (int a = 0; a < Dim; ++a)
+        if (!(p[a] >= tree->origin[a] && p[a] < tree->origin[a] + tree->size))
+            return nullptr;
+
+    const uint64_t code = sparse_tree_detail::encode<Dim>(*tree, p);
+    const SparseTreeNode* node = tree->getNodes();
+    if (node->pointNum == 0)
+        return nullptr;
+    while (!node->isLeaf()) {
+        const int digit = sparse_tree_detail::childDigit<Dim>(code, node->level);
+        if (!node->hasChild(digit))
+            return nullptr;
+        node = node->getChild(digit);
+    }
+    return node;
+}
+
+// fn(originalIndex, point) for every point in [boxMin, boxMax]
+template <int Dim, typename Fn>
+void forEachPointInBox(const SparseTree<Dim>* tree, const typename SparseTree<Dim>::Point& boxMin, const typename SparseTree<Dim>::Point& boxMax, Fn&& fn)
+{
+    using Cell = sparse_tree_detail::Cell<Dim>;
+    const SparsePoint<Dim>* points = tree->getPoints();
+    const uint32_t* indices = tree->getPointIndices();
+    if (tree->pointNum == 0)
+        return;
+
+    auto emitRange = [&](const SparseTreeNode& node) {
+        for (uint32_t i = node.firstPoint; i < node.firstPoint + node.pointNum; ++i) {
+            bool inside = true;
+            for (int a = 0; a < Dim; ++a)
+                inside &= points[i][a] >= boxMin[a] && points[i][a] <= boxMax[a];
+            if (inside)
+                fn(indices[i], points[i]);
+        }
+    };
+
+    // float cell bounds may differ from the quantized ones by rounding
+    const float eps = tree->size * 1e-6f;
+
+    struct Entry {
+        const SparseTreeNode* node;
+        Cell cell;
+    };
+    std::vector<Entry> stack { { tree->getNodes(), sparse_tree_detail::rootCell(tree) } };
+    while (!stack.empty()) {
+        const Entry entry = stack.back();
+        stack.pop_back();
+
+        bool overlaps = true, contained = true;
+        for (int a = 0; a < Dim; ++a) {
+            const float cellMax = entry.cell.min[a] + entry.cell.size;
+            overlaps &= entry.cell.min[a] - eps <= boxMax[a] && cellMax + eps >= boxMin[a];
+            contained &= entry.cell.min[a] - eps >= boxMin[a] && cellMax + eps <= boxMax[a];
+        }
+        if (!overlaps)
+            continue;
+
+        // whole subtree is one contiguous range of points
+        if (contained || entry.node->isLeaf()) {
+            emitRange(*entry.node);
+            continue;
+        }
+        for (int i = SparseTree<Dim>::childNum - 1; i >= 0; --i)
+            if (entry.node->hasChild(i))
+                stack.push_back({ entry.node->getChild(i), entry.cell.child(i) });
+    }
+}
+
+struct SparseTreeHit {
+    const SparseTreeNode* node = nullptr; // first occupied leaf cell along the ray
+    float t = std::numeric_limits<float>::infinity(); // entry distance into its cell
+};
+
+// first occupied leaf cell hit by origin + t * dir, t in [tMin, tMax], front to back
+template <int Dim>
+SparseTreeHit raycastSparseTree(const SparseTree<Dim>* tree, const typename SparseTree<Dim>::Point& origin, const typename SparseTree<Dim>::Point& dir,
+    float tMin = 0.0f, float tMax = std::numeric_limits<float>::infinity())
+{
+    using Cell = sparse_tree_detail::Cell<Dim>;
+    SparseTreeHit hit;
+    if (tree->pointNum == 0)
+        return hit;
+
+    float invDir[Dim];
+    for (int a = 0; a < Dim; ++a)
+        invDir[a] = dir[a] != 0.0f ? 1.0f / dir[a] : std::copysign(std::numeric_limits<float>::infinity(), dir[a]);
+
+    auto entryDistance = [&](const Cell& cell) {
+        float tEnter = tMin, tExit = tMax;
+        for (int a = 0; a < Dim; ++a) {
+            const float t1 = (cell.min[a] - origin[a]) * invDir[a];
+            const float t2 = (cell.min[a] + cell.size - origin[a]) * invDir[a];
+            tEnter = std::max(tEnter, std::min(t1, t2));
+            tExit = std::min(tExit, std::max(t1, t2));
+        }
+        return tEnter <= tExit ? tEnter : std::numeric_limits<float>::infinity();
+    };
+
+    struct Entry {
+        const SparseTreeNode* node;
+        Cell cell;
+        float t;
+    };
+    const Cell root = sparse_tree_detail::rootCell(tree);
+    const float rootT = entryDistance(root);
+    if (rootT == std::numeric_limits<float>::infinity())
+        return hit;
+
+    // cells do not overlap, so near-first depth-first order reaches leaves in order of distance
+    std::vector<Entry> stack { { tree->getNodes(), root, rootT } };
+    while (!stack.empty()) {
+        const Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.node->isLeaf()) {
+            hit.node = entry.node;
+            hit.t = entry.t;
+            return hit;
+        }
+
+        Entry children[SparseTree<Dim>::childNum];
+        int hitNum = 0;
+        for (int i = 0; i < SparseTree<Dim>::childNum; ++i) {
+            if (!entry.node->hasChild(i))
+                continue;
+            const Cell cell = entry.cell.child(i);
+            const float t = entryDistance(cell);
+            if (t == std::numeric_limits<float>::infinity())
+                continue;
+            int j = hitNum++;
+            for (; j > 0 && children[j - 1].t < t; --j) // far to near
+                children[j] = children[j - 1];
+            children[j] = { entry.node->getChild(i), cell, t };
+        }
+        stack.insert(stack.end(), children, children + hitNum);
+    }
+    return hit;
+}
+
+#endif // SPARSE_TREE_H
@@ -0,0 +1,250 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bvh.h"
+#include "simd_float.h"
+
+/* Wide BVH (BVH4 / BVH8), collapsed from a binary Bvh
+ *
+ * WideBvhNode<Width> keeps child bounds in SoA (minX[Width], minY[Width], ...),
+ * so one node is tested against a ray with one SIMD slab test (SSE for 4, AVX for 8).
+ * Nodes are in depth-first order in the arena, inner children are RELATIVE offsets (in nodes)
+ * from the parent, leaf children are triangle ranges. WideBvhNode<4> is 128 bytes, <8> is 256.
+ *
+ * Collapse: start from the 2 children of a binary node, open the inner child
+ * with the largest surface area until there are Width children.
+ * Traversal: hit children are sorted by entry distance and pushed far to near.
+ *
+ * size_t wideOffset = buildWideBvh<4>(buf, getBvh(buf, bvhOffset));
+ * intersectWideBvh(getWideBvh<4>(buf, wideOffset), ray, hit);
+ */
+
+template <int Width>
+struct alignas(64) WideBvhNode {
+    float minX[Width], minY[Width], minZ[Width];
+    float maxX[Width], maxY[Width], maxZ[Width];
+    uint32_t child[Width]; // inner: offset to child node, leaf: first triangle
+    uint16_t triangleNum[Width]; // 0 for inner child
+    uint8_t childNum;
+
+    bool isLeaf(int slot) const { return triangleNum[slot] != 0; }
+    const WideBvhNode* getChild(int slot) const { return this + child[slot]; }
+
+    void setBounds(int slot, const Vec3& bmin, const Vec3& bmax)
+    {
+        minX[slot] = bmin.x, minY[slot] = bmin.y, minZ[slot] = bmin.z;
+        maxX[slot] = bmax.x, maxY[slot] = bmax.y, maxZ[slot] = bmax.z;
+    }
+};
+static_assert(sizeof(WideBvhNode<4>) == 128);
+static_assert(sizeof(WideBvhNode<8>) == 256);
+
+template <int Width>
+struct WideBvh {
+    using Node = WideBvhNode<Width>;
+
+    uint32_t nodeNum;
+    uint32_t triangleNum;
+    uint64_t nodesRel;
+    uint64_t trianglesRel;
+    uint64_t triangleIndicesRel;
+
+    const Node* getNodes() const { return (const Node*)((const uint8_t*)this + nodesRel); }
+    const Triangle* getTriangles() const { return (const Triangle*)((const uint8_t*)this + trianglesRel); }
+    const uint32_t* getTriangleIndices() const { return (const uint32_t*)((const uint8_t*)this + triangleIndicesRel); }
+};
+
+template <int Width, typename BufferType>
+const WideBvh<Width>* getWideBvh(const BufferType& buf, size_t wideOffset) { return (const WideBvh<Width>*)(buf.data + wideOffset); }
+
+namespace wide_bvh_detail {
+
+template <int Width>
+struct Collapser {
+    using Node = WideBvhNode<Width>;
+
+    const BvhNode* binaryNodes;
+    std::vector<Node> nodes;
+
+    static float surfaceArea(const BvhNode& n) { return Aabb { n.getMin(), n.getMax() }.surfaceArea(); }
+
+    // binary node index -> wide node index, children are emitted after their parent
+    uint32_t collapse(uint32_t binaryIndex)
+    {
+        uint32_t children[Width];
+        int childNum = 0;
+        const BvhNode& binary = binaryNodes[binaryIndex];
+        if (binary.isLeaf()) // only for a leaf root
+            children[childNum++] = binaryIndex;
+        else {
+            children[childNum++] = binaryIndex + 1;
+            children[childNum++] = binaryIndex + binary.rightOrFirst;
+        }
+
+        while (childNum < Width) {
+            int widest = -1;
+            float widestArea = -1.0f;
+            for (int i = 0; i < childNum; ++i) {
+                const BvhNode& c = binaryNodes[children[i]];
+                if (!c.isLeaf() && surfaceArea(c) > widestArea) {
+                    widest = i;
+                    widestArea = surfaceArea(c);
+                }
+            }
+            if (widest < 0)
+                break;
+            const uint32_t opened = children[widest];
+            children[widest] = opened + 1;
+            children[childNum++] = opened + binaryNodes[opened].rightOrFirst;
+        }
+
+        const uint32_t wideIndex = nodes.size();
+        nodes.emplace_back();
+        memset(&nodes[wideIndex], 0, sizeof(Node));
+        nodes[wideIndex].childNum = childNum;
+        for (int i = 0; i < childNum; ++i) {
+            const BvhNode& c = binaryNodes[children[i]];
+            nodes[wideIndex].setBounds(i, c.getMin(), c.getMax());
+            if (c.isLeaf()) {
+                assert(c.triangleNum <= UINT16_MAX);
+                nodes[wideIndex].child[i] = c.rightOrFirst;
+                nodes[wideIndex].triangleNum[i] = c.triangleNum;
+            }
+        }
+        for (int i = 0; i < childNum; ++i)
+            if (!binaryNodes[children[i]].isLeaf()) {
+                const uint32_t childIndex = collapse(children[i]);
+                nodes[wideIndex].child[i] = childIndex - wideIndex;
+            }
+        return wideIndex;
+    }
+};
+
+} // namespace wide_bvh_detail
+
+// copies triangles of bvh, wide BVH does not depend on it after the build
+template <int Width, typename BufferType>
+size_t buildWideBvh(BufferType& buf, const Bvh* bvh)
+{
+    using Node = WideBvhNode<Width>;
+
+    wide_bvh_detail::Collapser<Width> collapser { bvh->getNodes(), {} };
+    collapser.nodes.reserve(bvh->nodeNum / (Width - 1) + 1);
+    if (bvh->triangleNum)
+        collapser.collapse(0);
+    else
+        collapser.nodes.emplace_back(); // childNum 0, never hit
+
+    const size_t wideOffset = buf.template allocate<WideBvh<Width>>(1);
+    const size_t nodesOffset = buf.template allocate<Node>(collapser.nodes.size());
+    const size_t trianglesOffset = buf.template allocate<Triangle>(bvh->triangleNum);
+    const size_t indicesOffset = buf.template allocate<uint32_t>(bvh->triangleNum);
+
+    WideBvh<Width>* wide = (WideBvh<Width>*)(buf.data + wideOffset);
+    wide->nodeNum = collapser.nodes.size();
+    wide->triangleNum = bvh->triangleNum;
+    wide->nodesRel = nodesOffset - wideOffset;
+    wide->trianglesRel = trianglesOffset - wideOffset;
+    wide->triangleIndicesRel = indicesOffset - wideOffset;
+
+    memcpy(buf.data + nodesOffset, collapser.nodes.data(), collapser.nodes.size() * sizeof(Node));
+    memcpy(buf.data + trianglesOffset, bvh->getTriangles(), bvh->triangleNum * sizeof(Triangle));
+    memcpy(buf.data + indicesOffset, bvh->getTriangleIndices(), bvh->triangleNum * sizeof(uint32_t));
+    return wideOffset;
+}
+
+// entry distances of all children, returns mask of hit children
+template <int Width>
+int intersectWideNode(const WideBvhNode<Width>& node, const SimdFloat<Width> origin[3], const SimdFloat<Width> invDir[3],
+    float tMin, float tMax, float* tEnterOut)
+{
+    using F = SimdFloat<Width>;
+    const F tx1 = (F::load(node.minX) - origin[0]) * invDir[0], tx2 = (F::load(node.maxX) - origin[0]) * invDir[0];
+    const F ty1 = (F::load(node.minY) - origin[1]) * invDir[1], ty2 = (F::load(node.maxY) - origin[1]) * invDir[1];
+    const F tz1 = (F::load(node.minZ) - origin[2]) * invDir[2], tz2 = (F::load(node.maxZ) - origin[2]) * invDir[2];
+    const F tEnter = max(max(min(tx1, tx2), min(ty1, ty2)), max(min(tz1, tz2), F::broadcast(tMin)));
+    const F tExit = min(min(max(tx1, tx2), max(ty1, ty2)), min(max(tz1, tz2), F::broadcast(tMax)));
+    tEnter.store(tEnterOut);
+    return (tEnter <= tExit).moveMask() & ((1 << node.childNum) - 1);
+}
+
+template <int Width, bool AnyHit = false>
+bool intersectWideBvh(const WideBvh<Width>* bvh, const Ray& ray, BvhHit& hit)
+{
+    using F = SimdFloat<Width>;
+    if (bvh->triangleNum == 0)
+        return false;
+
+    const WideBvhNode<Width>* nodes = bvh->getNodes();
+    const Triangle* triangles = bvh->getTriangles();
+    const Vec3 inv = safeInverse(ray.dir);
+    const F origin[3] = { F::broadcast(ray.origin.x), F::broadcast(ray.origin.y), F::broadcast(ray.origin.z) };
+    const F invDir[3] = { F::broadcast(inv.x), F::broadcast(inv.y), F::broadcast(inv.z) };
+
+    Ray r = ray;
+    bool found = false;
+
+    struct Entry {
+        uint32_t index; // node or first triangle
+        uint32_t triangleNum; // 0 for node
+        float t;
+    } stack[bvhStackSize * Width];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, 0, r.tMin };
+
+    while (stackSize) {
+        const Entry entry = stack[--stackSize];
+        if (entry.t > r.tMax)
+            continue;
+
+        if (entry.triangleNum) {
+            for (uint32_t i = entry.index; i < entry.index + entry.triangleNum; ++i) {
+                float u, v;
+                const float t = intersectTriangle(triangles[i], r, u, v);
+                if (t < r.tMax) {
+                    r.tMax = t;
+                    hit.t = t, hit.u = u, hit.v = v;
+                    hit.triangle = i;
+                    found = true;
+                    if constexpr (AnyHit) {
+                        stackSize = 0;
+                        break;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const WideBvhNode<Width>& node = nodes[entry.index];
+        alignas(32) float tEnter[Width];
+        int mask = intersectWideNode(node, origin, invDir, r.tMin, r.tMax, tEnter);
+
+        // sort hit children near to far, push far first
+        Entry hits[Width];
+        int hitNum = 0;
+        while (mask) {
+            const int slot = __builtin_ctz(mask);
+            mask &= mask - 1;
+            Entry e = node.isLeaf(slot) ? Entry { node.child[slot], node.triangleNum[slot], tEnter[slot] }
+                                        : Entry { entry.index + node.child[slot], 0, tEnter[slot] };
+            int j = hitNum++;
+            for (; j > 0 && hits[j - 1].t > e.t; --j)
+                hits[j] = hits[j - 1];
+            hits[j] = e;
+        }
+        assert(stackSize + hitNum <= bvhStackSize * Width);
+        for (int i = hitNum; i-- > 0;)
+            stack[stackSize++] = hits[i];
+    }
+
+    if (found)
+        hit.triangle = bvh->getTriangleIndices()[hit.triangle];
+    return found;
+}
+
+#endif // WIDE_BVH_H
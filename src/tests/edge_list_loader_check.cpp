@@ -0,0 +1,92 @@
+/*
+ * Edge list loader checks, exit code is the number of failed checks
+ *
+ * edge-list-loader-check
+ */
+
+#include <memory>
+
+#include "../graph/edge_list_loader.h"
+
+using Graph = CsrGraph<uint32_t, uint32_t, float>;
+using Buffer = ArenaBuffer<(size_t(1) << 20)>;
+
+static int failNum = 0;
+
+static void check(bool condition, const char* name)
+{
+    printf("%-48s %s\n", name, condition ? "ok" : "FAILED");
+    failNum += !condition;
+}
+
+static bool writeFile(const char* path, const void* data, size_t size)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return false;
+    const bool ok = fwrite(data, 1, size, f) == size;
+    return (fclose(f) == 0) && ok;
+}
+
+static bool loadText(ThreadPool& pool, const char* text, size_t& graphOffset, Buffer& buf)
+{
+    const char* path = "edge_list_check.txt";
+    buf.size = 0;
+    const bool ok = writeFile(path, text, strlen(text)) && loadTextEdgeList<Graph>(pool, buf, path, graphOffset);
+    remove(path);
+    return ok;
+}
+
+static bool loadBinary(ThreadPool& pool, const EdgeListBinaryHeader& header, const uint32_t* records, size_t recordNum, Buffer& buf)
+{
+    const char* path = "edge_list_check.bin";
+    std::vector<uint8_t> file(sizeof(header) + recordNum * 8);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + sizeof(header), records, recordNum * 8);
+
+    size_t graphOffset;
+    buf.size = 0;
+    const bool ok = writeFile(path, file.data(), file.size()) && loadBinaryEdgeList<Graph>(pool, buf, path, graphOffset);
+    remove(path);
+    return ok;
+}
+
+int main()
+{
+    auto buf = std::make_unique<Buffer>();
+    ThreadPool pool(4);
+    size_t graphOffset;
+
+    // ids past "# Nodes:" grow the vertex number
+    bool ok = loadText(pool, "# Nodes: 3 Edges: 3\n0 1\n1 2\n2 7\n", graphOffset, *buf);
+    check(ok && getCsrGraph<Graph>(*buf, graphOffset)->vertexNum == 8, "SNAP ids past header node count");
+
+    check(loadText(pool, "0 1\n1 2\n", graphOffset, *buf), "plain edge list");
+    check(!loadText(pool, "0 1\n5\n1 2\n", graphOffset, *buf), "single number line is rejected");
+    check(!loadText(pool, "0 1\n99999999999999999999999 2\n", graphOffset, *buf), "id past vertex type is rejected");
+    check(!loadText(pool, "0 1\n1 4000000000\n", graphOffset, *buf) && buf->size == 0, "vertex number past arena is rejected");
+
+    const char* matrixMarket = "%%MatrixMarket matrix coordinate pattern general\n3 3 2\n1 2\n2 3\n";
+    check(loadText(pool, matrixMarket, graphOffset, *buf), "Matrix Market");
+    check(!loadText(pool, "%%MatrixMarket matrix coordinate pattern general\n3 3 2\n0 2\n2 3\n", graphOffset, *buf),
+        "Matrix Market 0 id is rejected");
+    check(!loadText(pool, "%%MatrixMarket matrix coordinate pattern general\n3 3 2\n1 2\n2 4\n", graphOffset, *buf),
+        "Matrix Market id past size line is rejected");
+
+    EdgeListBinaryHeader header {};
+    header.magic = EdgeListBinaryHeader::currentMagic;
+    header.vertexNum = 4;
+    header.edgeNum = 2;
+    const uint32_t records[] = { 0, 1, 2, 3 };
+    check(loadBinary(pool, header, records, 2, *buf), "binary edge list");
+    const uint32_t badRecords[] = { 0, 1, 2, 4 };
+    check(!loadBinary(pool, header, badRecords, 2, *buf), "binary id past header vertex number is rejected");
+    header.vertexNum = 0xFFFFFFFF; // 16 GiB of offsets
+    header.edgeNum = 0;
+    check(!loadBinary(pool, header, records, 0, *buf) && buf->size == 0, "binary vertex number past arena is rejected");
+    header.vertexNum = 4;
+    header.edgeNum = (uint64_t(1) << 62) + 1; // edgeNum * 8 wraps to 8
+    check(!loadBinary(pool, header, records, 2, *buf), "binary edge number overflow is rejected");
+
+    return failNum;
+}
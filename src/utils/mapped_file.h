@@ -0,0 +1,63 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// read-only file mapping, whole file
+class MappedFile {
+    void* m_mapping = MAP_FAILED;
+    size_t m_size {};
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char* path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // advice goes to madvise, MADV_SEQUENTIAL reads ahead aggressively, MADV_WILLNEED prefetches the whole file
+    bool open(const char* path, int advice = MADV_SEQUENTIAL)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        m_size = fileStat.st_size;
+        m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (m_mapping == MAP_FAILED) {
+            m_size = 0;
+            return false;
+        }
+        madvise(m_mapping, m_size, advice);
+        return true;
+    }
+
+    void close()
+    {
+        if (m_mapping != MAP_FAILED)
+            munmap(m_mapping, m_size);
+        m_mapping = MAP_FAILED;
+        m_size = 0;
+    }
+
+    bool isOpen() const { return m_mapping != MAP_FAILED; }
+    const uint8_t* data() const { return (const uint8_t*)m_mapping; }
+    size_t size() const { return m_size; }
+};
+
+#endif // MAPPED_FILE_H
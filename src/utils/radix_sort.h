@@ -0,0 +1,92 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "thread_pool.h"
+
+/* Parallel LSD radix sort of (key, value) pairs, 8 bit digits
+ *
+ * Every pass: tasks count digits of their chunk, one exclusive scan over (digit, task) gives every
+ * task its own output range for every digit, tasks scatter without atomics. Stable, O(N * passes).
+ * Passes where all keys have the same digit are skipped, keyBits limits passes for short keys
+ * (30 bit Morton codes need 4 passes, not 8).
+ */
+
+template <typename Key, typename Value>
+void parallelRadixSortPairs(ThreadPool& pool, Key* keys, Value* values, size_t num, int keyBits = sizeof(Key) * 8)
+{
+    static_assert(std::is_unsigned_v<Key>);
+    constexpr int digitBits = 8;
+    constexpr int digitNum = 1 << digitBits;
+
+    if (num < 2)
+        return;
+
+    const int taskNum = (int)std::max<size_t>(1, std::min<size_t>(pool.getThreadNum() * 4, num / 4096));
+    const size_t chunkSize = (num + taskNum - 1) / taskNum;
+
+    std::vector<Key> keysTmp(num);
+    std::vector<Value> valuesTmp(num);
+    Key* srcKeys = keys;
+    Value* srcValues = values;
+    Key* dstKeys = keysTmp.data();
+    Value* dstValues = valuesTmp.data();
+
+    std::vector<std::array<size_t, digitNum>> counts(taskNum);
+
+    for (int shift = 0; shift < keyBits; shift += digitBits) {
+        pool.parallelFor(taskNum, [&](int task) {
+            auto& count = counts[task];
+            count.fill(0);
+            const size_t end = std::min(num, (task + 1) * chunkSize);
+            for (size_t i = task * chunkSize; i < end; ++i)
+                ++count[(srcKeys[i] >> shift) & (digitNum - 1)];
+        });
+
+        // skip pass if every key has the same digit
+        size_t maxDigitCount = 0;
+        for (int d = 0; d < digitNum; ++d) {
+            size_t digitCount = 0;
+            for (int task = 0; task < taskNum; ++task)
+                digitCount += counts[task][d];
+            maxDigitCount = std::max(maxDigitCount, digitCount);
+        }
+        if (maxDigitCount == num)
+            continue;
+
+        size_t offset = 0; // counts become output positions
+        for (int d = 0; d < digitNum; ++d)
+            for (int task = 0; task < taskNum; ++task) {
+                const size_t c = counts[task][d];
+                counts[task][d] = offset;
+                offset += c;
+            }
+
+        pool.parallelFor(taskNum, [&](int task) {
+            auto& position = counts[task];
+            const size_t end = std::min(num, (task + 1) * chunkSize);
+            for (size_t i = task * chunkSize; i < end; ++i) {
+                const size_t p = position[(srcKeys[i] >> shift) & (digitNum - 1)]++;
+                dstKeys[p] = srcKeys[i];
+                dstValues[p] = srcValues[i];
+            }
+        });
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcValues, dstValues);
+    }
+
+    if (srcKeys != keys) {
+        pool.parallelForRange(size_t(0), num, [&](size_t b, size_t e) {
+            std::copy(srcKeys + b, srcKeys + e, keys + b);
+            std::copy(srcValues + b, srcValues + e, values + b);
+        });
+    }
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,151 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ThreadPool
+ *
+ * Fixed set of workers for data-parallel loops, no task queue.
+ * parallelFor(taskNum, fn) hands task indices out through one atomic counter,
+ * the calling thread works too and returns when every task is finished.
+ *
+ * ThreadPool pool(4);
+ * pool.parallelFor(groupNum, [&](int taskIndex) { process(taskIndex); });
+ *
+ * parallelFor called from inside a task runs serially on the calling worker.
+ * Pool is driven by one thread at a time.
+ */
+
+class ThreadPool {
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    const std::function<void(int)>* m_job {};
+    int m_jobTaskNum {};
+    uint64_t m_jobGeneration {};
+    int m_busyWorkerNum {};
+    bool m_stop {};
+
+    std::atomic<int> m_nextTask {};
+
+    static bool& isInsideTask()
+    {
+        static thread_local bool insideTask = false;
+        return insideTask;
+    }
+
+    void runTasks(const std::function<void(int)>& job, int taskNum)
+    {
+        isInsideTask() = true;
+        for (int taskIndex = m_nextTask.fetch_add(1); taskIndex < taskNum; taskIndex = m_nextTask.fetch_add(1))
+            job(taskIndex);
+        isInsideTask() = false;
+    }
+
+    void workerLoop()
+    {
+        uint64_t seenGeneration = 0;
+        for (;;) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [&] { return m_stop || m_jobGeneration != seenGeneration; });
+            if (m_stop)
+                return;
+
+            seenGeneration = m_jobGeneration;
+            if (!m_job) // woke up after the job was finished
+                continue;
+
+            const auto* job = m_job;
+            const int taskNum = m_jobTaskNum;
+            ++m_busyWorkerNum;
+            lock.unlock();
+
+            runTasks(*job, taskNum);
+
+            lock.lock();
+            if (--m_busyWorkerNum == 0)
+                m_doneCondition.notify_all();
+        }
+    }
+
+public:
+    explicit ThreadPool(int threadNum = std::thread::hardware_concurrency())
+    {
+        threadNum = std::max(threadNum, 1);
+        m_workers.reserve(threadNum - 1); // calling thread is a worker too
+        for (int i = 1; i < threadNum; ++i)
+            m_workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeCondition.notify_all();
+        for (auto& worker : m_workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getThreadNum() const { return (int)m_workers.size() + 1; }
+
+    // fn(taskIndex) for every taskIndex in [0, taskNum), blocks until all tasks are done
+    void parallelFor(int taskNum, const std::function<void(int)>& fn)
+    {
+        if (taskNum <= 0)
+            return;
+
+        if (taskNum == 1 || m_workers.empty() || isInsideTask()) {
+            for (int taskIndex = 0; taskIndex < taskNum; ++taskIndex)
+                fn(taskIndex);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [&] { return m_busyWorkerNum == 0; }); // previous job may still be draining
+        m_job = &fn;
+        m_jobTaskNum = taskNum;
+        m_nextTask = 0;
+        ++m_jobGeneration;
+        lock.unlock();
+        m_wakeCondition.notify_all();
+
+        runTasks(fn, taskNum);
+
+        lock.lock();
+        m_doneCondition.wait(lock, [&] { return m_busyWorkerNum == 0; });
+        m_job = nullptr;
+    }
+
+    // splits [begin, end) into about taskPerThread * threadNum ranges, fn(rangeBegin, rangeEnd)
+    template <typename IndexType, typename Fn>
+    void parallelForRange(IndexType begin, IndexType end, Fn&& fn, int taskPerThread = 4)
+    {
+        if (end <= begin)
+            return;
+        const int64_t itemNum = (int64_t)(end - begin);
+        const int taskNum = (int)std::min<int64_t>(itemNum, (int64_t)getThreadNum() * taskPerThread);
+        parallelFor(taskNum, [&](int taskIndex) {
+            const IndexType rangeBegin = begin + (IndexType)(itemNum * taskIndex / taskNum);
+            const IndexType rangeEnd = begin + (IndexType)(itemNum * (taskIndex + 1) / taskNum);
+            fn(rangeBegin, rangeEnd);
+        });
+    }
+};
+
+#endif // THREAD_POOL_H